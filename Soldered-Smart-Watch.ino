@@ -21,20 +21,30 @@
 #include "src/defines.h"
 
 // Include other external files and libraries
-#include "LSM6DS3-SOLDERED.h" // Gyroscope library
-#include "src/Display.h"      // Display driver
-#include "src/Network.h"      // Network functions
-#include "src/WSLED.h"        // Onboard RGB LED driver
-#include "time.h"             // For storing time data
-#include <RBD_Button.h>       // Button driver
-#include <RBD_Timer.h>        // Required for button driver
+#include "LSM6DS3-SOLDERED.h"  // Gyroscope library
+#include "src/Activity.h"      // Cadence, distance and calorie estimates
+#include "src/Display.h"       // Display driver
+#include "src/I2cQueue.h"      // Shared I2C bus for the display and the gyroscope
+#include "src/Input.h"         // Button and tap input events
+#include "src/MemoryMonitor.h" // Memory usage report
+#include "src/Network.h"       // Network functions
+#include "src/Notifications.h" // Notification receiver
+#include "src/WSLED.h"         // Onboard RGB LED driver
+#include "time.h"              // For storing time data
+#include <RBD_Button.h>        // Button driver
+#include <RBD_Timer.h>         // Required for button driver
 
 // Let's declare objects which run the different features of the device
+I2cQueue i2cBus;                // I2C transactions for the display and gyroscope
 Network network;                // Network functions
 Display display;                // OLED display
 Soldered_LSM6DS3 gyro;          // Gyroscope
 Wsled led;                      // RGB LED
 RBD::Button button(BUTTON_PIN); // Button
+Input input;                    // Button presses and taps
+Notifications notifications;    // Notifications received over WiFi
+MemoryMonitor memory;           // Memory usage report
+Activity activity;              // Activity statistics
 
 // Local variable to remember the time when the RTC was last synchronized
 time_t lastSyncAttemptTime;
@@ -48,6 +58,15 @@ uint8_t lastRememberedWeekday = 0;
 // Remember if low battery alert is active or not
 bool lowBattery = false;
 
+// Remember if the last RTC sync failed, the watch face shows it
+bool lastSyncFailed = false;
+
+// The last step count read from the gyroscope, it's updated by the I2C queue while the main loop waits
+uint16_t numSteps = 0;
+
+// When the bus statistics were last printed
+uint32_t lastStatsReportTime = 0;
+
 // Setup code, runs only once at startup
 void setup()
 {
@@ -60,15 +79,18 @@ void setup()
 
     // Let's try to initialize the OLED display
     DEBUG_PRINT("Initializing OLED display...");
-    if (!display.begin())
+    if (!display.begin(&i2cBus))
     {
         errorHandling("Couldn't initialize OLED display!");
     }
     DEBUG_PRINT("OLED display initialized!");
 
-    // Let's try to initialize the OLED display
+    // Let's try to initialize the onboard LED
     DEBUG_PRINT("Initializing WSLED...");
-    led.begin();
+    if (!led.begin())
+    {
+        errorHandling("Couldn't initialize WSLED!");
+    }
     DEBUG_PRINT("WSLED initialized!");
 
     // Let's initialize the gyroscope
@@ -82,6 +104,12 @@ void setup()
     // Now that the gyro is init'ed, also configure it!
     configGyro();
 
+    // Both the display and the gyro have started the I2C bus, now set its speed
+    i2cBus.begin(I2C_BUS_CLOCK_HZ);
+
+    // Start listening for the button and taps
+    input.begin(&button, &i2cBus, GYRO_INT_PIN);
+
     // Let's attempt to connect to WiFi
     DEBUG_PRINT("Connecting to WiFi...");
     display.showLoadingMessage(OLED_WIFI_CONNECTING_MSG); // Show a message on the OLED also
@@ -105,14 +133,29 @@ void setup()
     }
     DEBUG_PRINT("Got time and saved to RTC!");
 
+    // Start listening for notifications, the watch works fine without them so this isn't fatal
+    DEBUG_PRINT("Starting notification receiver...");
+    if (!notifications.begin(NOTIF_UDP_PORT))
+    {
+        DEBUG_PRINT("Couldn't start notification receiver!");
+    }
+    DEBUG_PRINT(WiFi.localIP()); // Send notifications to this address
+
     // Save the last sync attempt time
     lastSyncAttemptTime = time(nullptr);
     pinMode(BATTERY_VOLTAGE_PIN, INPUT);
+
+    // Everything is allocated by now, from here on every allocation of the main loop is counted
+    memory.setupDone();
+    memory.printReport();
 }
 
 // The main loop of the program
 void loop()
 {
+    // Report it if the last pass allocated anything on the heap, it shouldn't
+    memory.checkLoop();
+
     // Let's turn off the LED in case it was left on
     led.ledOff();
 
@@ -142,13 +185,26 @@ void loop()
 
         // Now reset the step count
         configGyro(); // Configuring the gyro resets the step count
+        numSteps = 0;
+        activity.resetDay();
     }
 
-    // Let's get the currently measured number of steps
-    uint32_t numSteps = getNumSteps();
-
-    // Draw the current time and step count, and the low battery alert if so
-    display.drawTimeAndStepCount(currentTime, numSteps, lowBattery);
+    // Update the activity statistics with the steps read during the last wait
+    activity.update(currentTime, numSteps);
+
+    // Draw the watch face with the current time and step count, and the low battery alert if so
+    FaceState faceState;
+    faceState.time = currentTime;
+    faceState.steps = numSteps;
+    faceState.lowBattery = lowBattery;
+    faceState.syncFailed = lastSyncFailed;
+    faceState.cadence = activity.cadence();
+    faceState.cadenceLong = activity.cadenceLong();
+    faceState.distanceMeters = activity.distanceMeters();
+    faceState.calories = activity.calories();
+    faceState.activeMinutes = activity.activeMinutes();
+    faceState.longestStreak = activity.longestStreak();
+    display.drawFace(&faceState);
 
     // Check if it's time to re-sync the RTC
     if (timeDifference >= RTC_SYNC_INTERVAL_SEC)
@@ -186,25 +242,52 @@ void loop()
             wifiConnected = true;
         }
 
-        if (wifiConnected)
+        // Now get the time and save it to RTC
+        lastSyncFailed = !wifiConnected || !network.getTimeAndSaveToRTC(ntpServer, timeZone, RTC_CONFIG_TIMEOUT_SEC);
+        if (!lastSyncFailed)
         {
-            // Now get the time and save it to RTC
-            network.getTimeAndSaveToRTC(ntpServer, timeZone, RTC_CONFIG_TIMEOUT_SEC);
             DEBUG_PRINT("Updated time and saved to RTC!");
         }
     }
 
-    // Now let's wait and periodically check for the button
+    // Print the bus and memory statistics every once in a while
+    if (DEBUG && millis() - lastStatsReportTime >= STATS_REPORT_INTERVAL_MS)
+    {
+        lastStatsReportTime = millis();
+        i2cBus.printStats();
+        memory.printReport();
+    }
+
+    // Read the number of steps in the background while waiting, it's ready by the next pass
+    requestNumSteps();
+
+    // Now let's wait and periodically check for input and notifications
     for (int i = 0; i < 500; i++)
     {
         // Wait 3 ms 500 times -> 1500 ms total
         delay(3);
-        // If the flag was set in the meantime, do button action
-        if (button.onPressed())
+
+        // Read the steps and send a part of the watch face to the display
+        i2cBus.service(I2C_SERVICE_BUDGET_US);
+
+        // If the button was pressed or the watch double tapped in the meantime, go to the menu
+        // Single taps are ignored here, so bumping the watch doesn't open the menu
+        input.poll();
+        InputEvent event;
+        if (input.getEvent(&event) && event.type != INPUT_EVENT_TAP)
         {
             // Launch menu which selects feature
-            DEBUG_PRINT("Button pressed - going to menu!");
-            menu();
+            DEBUG_PRINT("Going to menu!");
+            menu(&event);
+        }
+
+        // If something new arrived, flash the LED and show it
+        if (notifications.poll())
+        {
+            DEBUG_PRINT("Notification received!");
+            led.notificationBlink(notifications.highestUnreadPriority());
+            display.notificationTicker(&notifications, &input);
+            return; // Redraw the watch face right away
         }
     }
 }
@@ -242,8 +325,8 @@ void configGyro()
 
     // Configure range to lower range
     dataToWrite |= LSM6DS3_ACC_GYRO_FS_XL_2g;
-    // Configure data rate
-    dataToWrite |= LSM6DS3_ACC_GYRO_ODR_XL_26Hz;
+    // Configure data rate, tap recognition needs at least 416 Hz, the pedometer works at any rate
+    dataToWrite |= LSM6DS3_ACC_GYRO_ODR_XL_416Hz;
     // Now, write the patched together data
     errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_CTRL1_XL, dataToWrite);
 
@@ -253,8 +336,18 @@ void configGyro()
 
     // Enable embedded functions -- ALSO clears the step count
     errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_CTRL10_C, 0x3E);
-    // Enable pedometer algorithm
-    errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_TAP_CFG1, 0x40);
+    // Enable pedometer algorithm and tap recognition on all axes, and latch the interrupt
+    // Without the latch the tap source register is only set for the quiet time (about 10 ms), which is often over
+    // before it's read. Latched, it holds until it's read, and reading it also clears the interrupt
+    errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_TAP_CFG1, 0x4F);
+    // Set the tap threshold, 12 * 62.5 mg at the 2g range
+    errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_TAP_THS_6D, 0x0C);
+    // Set the tap timing, about 230 ms between the taps of a double tap, 10 ms quiet and 40 ms shock time
+    errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_INT_DUR2, 0x36);
+    // Recognize double taps as well as single taps
+    errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_WAKE_UP_THS, 0x80);
+    // Signal single and double taps on the INT1 pin
+    errorAccumulator += gyro.writeRegister(LSM6DS3_ACC_GYRO_MD1_CFG, 0x48);
 
     // If there was an error, go to error handling
     if (errorAccumulator)
@@ -264,50 +357,64 @@ void configGyro()
 }
 
 /**
- * @brief Get the number of steps as measured by the gyroscope
+ * @brief Queue a read of the number of steps measured by the gyroscope, numSteps is updated when it's done
  *
- * @return uint16_t
  */
-uint16_t getNumSteps()
+void requestNumSteps()
 {
-    // Create placeholder variables
-    uint8_t readDataByte = 0;
-    uint16_t stepsTaken = 0;
-
-    // Read the 16bit value by two 8bit operations
-    gyro.readRegister(&readDataByte, LSM6DS3_ACC_GYRO_STEP_COUNTER_H);
-    stepsTaken = ((uint16_t)readDataByte) << 8;
-    gyro.readRegister(&readDataByte, LSM6DS3_ACC_GYRO_STEP_COUNTER_L);
-    stepsTaken |= readDataByte;
-
-    // Return it!
-    return stepsTaken;
+    // Read both bytes of the 16bit value in one transaction, the register address auto-increments
+    i2cBus.readRegisters(GYRO_I2C_ADDRESS, LSM6DS3_ACC_GYRO_STEP_COUNTER_L, 2, onNumStepsRead, nullptr);
 }
 
 /**
- * @brief The menu function, this is launched when the button is pressed
- * 
+ * @brief Called by the I2C queue when the step counter was read
+ *
  */
-void menu()
+void onNumStepsRead(void *_context, const uint8_t *_data, uint8_t _length, bool _success)
+{
+    // Keep the previous value if the read failed
+    if (_success)
+    {
+        numSteps = ((uint16_t)_data[1] << 8) | _data[0];
+    }
+}
+
+/**
+ * @brief The menu function, this is launched when the button is pressed or the watch is double tapped
+ *
+ * @param _openEvent The input event which opened the menu, to report the latency
+ */
+void menu(const InputEvent *_openEvent)
 {
     // Start measuring time
     uint32_t timeout = millis();
     int menuPage = 0; // Start with 0 for first press
-    
+
     // Show the menu page and color
     display.drawMenuPage(menuPage);
     led.showMenuColor(menuPage);
+    input.reportLatency(_openEvent, "open menu");
 
     // Go to infinite loop
     while (true)
     {
-        // If the button is pressed, keep counting the menu pages
-        if (button.onPressed())
+        input.poll();
+        InputEvent event;
+        if (input.getEvent(&event))
         {
+            // A double tap launches the page right away, without waiting for the timeout
+            if (event.type == INPUT_EVENT_DOUBLE_TAP)
+            {
+                input.reportLatency(&event, "select menu page");
+                launchMenuPage(menuPage);
+                return;
+            }
+
+            // The button or a single tap go to the next page
             menuPage++;
 
             // Watch if the pages roll over.
-            if (menuPage >= 4)
+            if (menuPage >= MENU_NUM_PAGES)
             {
                 menuPage = 0;
             }
@@ -315,39 +422,53 @@ void menu()
             // Show the current page
             display.drawMenuPage(menuPage);
             led.showMenuColor(menuPage);
-            
+            input.reportLatency(&event, "next menu page");
+
             // Reset the timer
             timeout = millis();
         }
 
-        // When the timeout is over, launch  the according function
+        // When the timeout is over, launch the according function
         if (millis() - timeout > MENU_TIMEOUT_MS)
         {
-            if (menuPage == 0)
-            {
-                display.wifiScanner(&button);
-                return;
-            }
-            else if (menuPage == 1)
-            {
-                display.gyroAnimation(&gyro, &button);
-                return;
-            }
-            else if (menuPage == 2)
-            {
-                // "Self destruct"
-                customFunction();
-                return;
-            }
-            else
-            {
-                // Go back
-                return;
-            }
+            launchMenuPage(menuPage);
+            return;
         }
     }
 }
 
+/**
+ * @brief Launch the function of the selected menu page
+ *
+ * @param _menuPage The index number of the menu page
+ */
+void launchMenuPage(int _menuPage)
+{
+    if (_menuPage == 0)
+    {
+        display.wifiScanner(&input);
+    }
+    else if (_menuPage == 1)
+    {
+        display.gyroAnimation(&gyro, &input);
+    }
+    else if (_menuPage == 2)
+    {
+        // "Self destruct"
+        customFunction();
+    }
+    else if (_menuPage == 3)
+    {
+        display.notificationTicker(&notifications, &input);
+    }
+    else if (_menuPage == 4)
+    {
+        // It's drawn as soon as we're back in the main loop
+        display.nextFace();
+    }
+    // Otherwise, go back
+}
+
 /**
  * @brief Write your own implementation here!
  * 
@@ -0,0 +1,276 @@
+#include "Activity.h"
+#include <string.h>
+
+/**
+ * @brief Construct a new Activity:: Activity object
+ *
+ */
+Activity::Activity()
+    : lastMinuteSteps(0), lastSecond(0), minuteHead(0), longWindowSteps(0), stepsThisMinute(0), currentMinute(0),
+      started(false), lastTotalSteps(0), stepsToday(0), numActiveMinutes(0), streak(0), bestStreak(0)
+{
+    memset(secondBuckets, 0, sizeof(secondBuckets));
+    memset(minuteBuckets, 0, sizeof(minuteBuckets));
+}
+
+/**
+ * @brief Add the steps counted since the last update
+ *
+ * @note  The steps are spread evenly over the seconds since the last update, so a long blocking screen doesn't put
+ *        all of them into one second. Only the last 60 seconds and ACTIVITY_LONG_WINDOW_MIN minutes are walked one by
+ *        one, so the cost doesn't depend on how long the watch has been running or how long the gap was
+ *
+ * @param _now the current time
+ * @param _totalSteps the step count as read from the gyroscope
+ */
+void Activity::update(time_t _now, uint32_t _totalSteps)
+{
+    if (!started)
+    {
+        // Nothing to compare the first reading to
+        started = true;
+        lastTotalSteps = _totalSteps;
+        clearWindows(_now);
+        return;
+    }
+
+    // If the count went down, the gyroscope was reset, so all of it is new
+    uint32_t newSteps = _totalSteps >= lastTotalSteps ? _totalSteps - lastTotalSteps : _totalSteps;
+    lastTotalSteps = _totalSteps;
+    stepsToday += newSteps;
+
+    // If the clock went back (RTC sync), the windows can't be lined up with the new time, so start them over
+    if (_now < lastSecond)
+    {
+        memset(secondBuckets, 0, sizeof(secondBuckets));
+        lastMinuteSteps = 0;
+        stepsThisMinute = 0;
+        lastSecond = _now;
+        currentMinute = _now / 60;
+    }
+
+    advance(_now, newSteps);
+}
+
+/**
+ * @brief Start a new day, call this when the gyroscope step count is reset
+ *
+ * @note  The cadence windows are kept, so walking through midnight doesn't drop the cadence
+ *
+ */
+void Activity::resetDay()
+{
+    lastTotalSteps = 0;
+    stepsToday = 0;
+    numActiveMinutes = 0;
+    streak = 0;
+    bestStreak = 0;
+}
+
+/**
+ * @brief Get the number of steps in the last minute
+ *
+ * @return uint16_t steps per minute
+ */
+uint16_t Activity::cadence()
+{
+    return lastMinuteSteps;
+}
+
+/**
+ * @brief Get the average cadence over the last ACTIVITY_LONG_WINDOW_MIN complete minutes
+ *
+ * @return uint16_t steps per minute
+ */
+uint16_t Activity::cadenceLong()
+{
+    return longWindowSteps / ACTIVITY_LONG_WINDOW_MIN;
+}
+
+/**
+ * @brief Get the number of steps since the day was reset
+ *
+ */
+uint32_t Activity::dailySteps()
+{
+    return stepsToday;
+}
+
+/**
+ * @brief Get the number of minutes today with at least ACTIVE_MINUTE_STEPS steps
+ *
+ */
+uint16_t Activity::activeMinutes()
+{
+    return numActiveMinutes;
+}
+
+/**
+ * @brief Get the number of active minutes in a row, up to the last complete minute
+ *
+ */
+uint16_t Activity::currentStreak()
+{
+    return streak;
+}
+
+/**
+ * @brief Get the most active minutes in a row today
+ *
+ */
+uint16_t Activity::longestStreak()
+{
+    return bestStreak;
+}
+
+/**
+ * @brief Estimate the distance walked today from the stride length
+ *
+ * @return uint32_t distance in meters
+ */
+uint32_t Activity::distanceMeters()
+{
+    return stepsToday * USER_STRIDE_CM / 100;
+}
+
+/**
+ * @brief Estimate the calories burned walking today from the distance and body weight
+ *
+ * @return uint32_t energy in kcal
+ */
+uint32_t Activity::calories()
+{
+    return (uint64_t)stepsToday * USER_STRIDE_CM * USER_WEIGHT_KG * USER_KCAL_PER_KG_KM_X100 / 10000000ULL;
+}
+
+/**
+ * @brief Move the windows forward to the current time, spreading the new steps over the seconds since the last update
+ *
+ * @param _now the current time, not before the last update
+ * @param _newSteps the steps counted since the last update
+ */
+void Activity::advance(time_t _now, uint32_t _newSteps)
+{
+    time_t start = lastSecond;
+    time_t elapsed = _now - start;
+
+    // Still the same second
+    if (elapsed == 0)
+    {
+        secondBuckets[_now % 60] += _newSteps;
+        lastMinuteSteps += _newSteps;
+        stepsThisMinute += _newSteps;
+        return;
+    }
+
+    // Fill the seconds between the last update and now, older ones than a minute ago would only be overwritten
+    for (time_t second = elapsed > 60 ? _now - 59 : start + 1; second <= _now; second++)
+    {
+        lastMinuteSteps -= secondBuckets[second % 60];
+        secondBuckets[second % 60] = stepsBetween(start, second - 1, second, elapsed, _newSteps);
+        lastMinuteSteps += secondBuckets[second % 60];
+    }
+
+    // Close the minutes which ended since the last update
+    time_t minuteStart = start;
+    while (currentMinute < _now / 60)
+    {
+        time_t minuteEnd = currentMinute * 60 + 59;
+        closeMinute(stepsThisMinute + stepsBetween(start, minuteStart, minuteEnd, elapsed, _newSteps));
+        minuteStart = minuteEnd;
+        currentMinute++;
+
+        // Minutes which fall out of the long window again still count for the active minutes
+        time_t skipped = _now / 60 - currentMinute - ACTIVITY_LONG_WINDOW_MIN;
+        if (skipped > 0)
+        {
+            skipMinutes(stepsBetween(start, minuteStart, minuteStart + skipped * 60, elapsed, _newSteps), skipped);
+            minuteStart += skipped * 60;
+            currentMinute += skipped;
+        }
+    }
+
+    stepsThisMinute += stepsBetween(start, minuteStart, _now, elapsed, _newSteps);
+    lastSecond = _now;
+}
+
+/**
+ * @brief Get the share of the steps which fall between two points in time, when they're spread evenly
+ *
+ * @note  Shares of neighbouring intervals add up exactly to the total, no step is lost to rounding
+ *
+ * @param _start when counting the steps started
+ * @param _from start of the interval, excluded
+ * @param _to end of the interval, included
+ * @param _elapsed how long counting the steps took, in seconds
+ * @param _steps the number of steps counted
+ */
+uint32_t Activity::stepsBetween(time_t _start, time_t _from, time_t _to, time_t _elapsed, uint32_t _steps)
+{
+    return (uint64_t)_steps * (_to - _start) / _elapsed - (uint64_t)_steps * (_from - _start) / _elapsed;
+}
+
+/**
+ * @brief Add a complete minute to the long window and update the active minute streak
+ *
+ */
+void Activity::closeMinute(uint16_t _steps)
+{
+    longWindowSteps -= minuteBuckets[minuteHead];
+    minuteBuckets[minuteHead] = _steps;
+    longWindowSteps += _steps;
+    minuteHead = (minuteHead + 1) % ACTIVITY_LONG_WINDOW_MIN;
+    stepsThisMinute = 0;
+
+    if (_steps >= ACTIVE_MINUTE_STEPS)
+    {
+        numActiveMinutes++;
+        streak++;
+        if (streak > bestStreak)
+        {
+            bestStreak = streak;
+        }
+    }
+    else
+    {
+        streak = 0;
+    }
+}
+
+/**
+ * @brief Count minutes which never make it into the long window, they only update the active minutes and streaks
+ *
+ * @param _steps the steps in all of those minutes together, they're spread evenly
+ * @param _minutes the number of minutes
+ */
+void Activity::skipMinutes(uint32_t _steps, time_t _minutes)
+{
+    if (_steps / _minutes >= ACTIVE_MINUTE_STEPS)
+    {
+        numActiveMinutes += _minutes;
+        streak += _minutes;
+        if (streak > bestStreak)
+        {
+            bestStreak = streak;
+        }
+    }
+    else
+    {
+        streak = 0;
+    }
+}
+
+/**
+ * @brief Empty both windows
+ *
+ */
+void Activity::clearWindows(time_t _now)
+{
+    memset(secondBuckets, 0, sizeof(secondBuckets));
+    memset(minuteBuckets, 0, sizeof(minuteBuckets));
+    lastMinuteSteps = 0;
+    longWindowSteps = 0;
+    stepsThisMinute = 0;
+    lastSecond = _now;
+    currentMinute = _now / 60;
+}
@@ -0,0 +1,54 @@
+#ifndef __SMART_WATCH_ACTIVITY__
+#define __SMART_WATCH_ACTIVITY__
+
+#include "defines.h"
+#include "time.h"
+#include <stdint.h>
+
+// Number of minutes in the long cadence window
+#define ACTIVITY_LONG_WINDOW_MIN 10
+
+class Activity
+{
+  public:
+    Activity();
+    void update(time_t _now, uint32_t _totalSteps);
+    void resetDay();
+    uint16_t cadence();
+    uint16_t cadenceLong();
+    uint32_t dailySteps();
+    uint16_t activeMinutes();
+    uint16_t currentStreak();
+    uint16_t longestStreak();
+    uint32_t distanceMeters();
+    uint32_t calories();
+
+  private:
+    // Steps per second over the last minute, with their running sum
+    uint16_t secondBuckets[60];
+    uint32_t lastMinuteSteps;
+    time_t lastSecond;
+
+    // Steps per minute over the last ACTIVITY_LONG_WINDOW_MIN complete minutes, with their running sum
+    uint16_t minuteBuckets[ACTIVITY_LONG_WINDOW_MIN];
+    uint8_t minuteHead;
+    uint32_t longWindowSteps;
+    uint16_t stepsThisMinute;
+    time_t currentMinute;
+
+    // Daily totals
+    bool started;
+    uint32_t lastTotalSteps;
+    uint32_t stepsToday;
+    uint16_t numActiveMinutes;
+    uint16_t streak;
+    uint16_t bestStreak;
+
+    void advance(time_t _now, uint32_t _newSteps);
+    uint32_t stepsBetween(time_t _start, time_t _from, time_t _to, time_t _elapsed, uint32_t _steps);
+    void closeMinute(uint16_t _steps);
+    void skipMinutes(uint32_t _steps, time_t _minutes);
+    void clearWindows(time_t _now);
+};
+
+#endif
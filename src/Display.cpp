@@ -1,16 +1,19 @@
 #include "Display.h"
 #include "LSM6DS3-SOLDERED.h"
+#include "Faces.h"
 #include "images.h"
 #include "defines.h"
 #include <WiFi.h>
+#include <new>
 
 /**
  * @brief Initialize the OLED display
  *
+ * @param _bus The I2C queue which is used to send frames to the display
  * @return true if it was successful
  * @return false if it failed
  */
-bool Display::begin()
+bool Display::begin(I2cQueue *_bus)
 {
     // Let's create the OLED display object
     // Check if oledDisplay already points to an OLED_Display object
@@ -23,7 +26,15 @@ bool Display::begin()
     }
 
     // Create a new OLED_Display object and assign its address to oledDisplay
+#if STATIC_ALLOCATION
+    // Construct it in static storage instead of on the heap
+    alignas(OLED_Display) static uint8_t oledDisplayStorage[sizeof(OLED_Display)];
+    oledDisplay = new (oledDisplayStorage) OLED_Display();
+#else
     oledDisplay = new OLED_Display();
+#endif
+    bus = _bus;
+    faceRenderer.setFace(faces[currentFace]);
 
     // Perform any initialization required for the OLED_Display object
     bool initSuccess = oledDisplay->begin();
@@ -47,49 +58,34 @@ void Display::showLoadingMessage(const char *_message)
     oledDisplay->setCursor(0, 40);
     oledDisplay->setTextColor(SSD1306_WHITE, SSD1306_BLACK);
     oledDisplay->print(_message);
-    oledDisplay->display(); // Show the Soldered Logo
+    flush(); // Show the Soldered Logo
 }
 
 /**
- * @brief The main drawing function which draws time and step count
+ * @brief The main drawing function which draws the selected watch face
  *
- * @param _currentTime The time to draw
- * @param _stepCount The number of steps to print
- * @param _lowBattery To draw the low battery indicator or not
+ * @note  Only the widgets whose value changed are drawn and sent to the display
+ *
+ * @param _state The time, step count and everything else the face can show
  */
-void Display::drawTimeAndStepCount(time_t _currentTime, uint32_t _stepCount, bool _lowBattery)
+void Display::drawFace(const FaceState *_state)
 {
-    // Transform time to local time, so we can get the hours and minutes
-    struct tm *timeinfo = localtime(&_currentTime);
-    char timeString[6]; // Buffer to hold the formatted time; HH:MM + null terminator
-    char dateString[8]; // Buffer to hold the formatted date; HH:MM + null terminator
-    // Print the time and date in the set format
-    sprintf(timeString, "%02d:%02d", timeinfo->tm_hour, timeinfo->tm_min);
-    sprintf(dateString, "%02d.%02d.", timeinfo->tm_mday, timeinfo->tm_mon + 1);
-
-    // Let's draw everything on the display
-    oledDisplay->clearDisplay();                             // Clear the display buffer
-    oledDisplay->setCursor(5, 9);                            // Set the cursor for printing time
-    oledDisplay->setTextColor(SSD1306_WHITE, SSD1306_BLACK); // Set the text color
-    oledDisplay->setTextSize(4);                             // Set font size to large
-    oledDisplay->print(timeString);                          // Print the time string
-    oledDisplay->setTextSize(1);                             // Set font size back to small
-    oledDisplay->setCursor(2, 54);                           // Set the cursor to the position for steps
-    oledDisplay->print(dateString);                          // Print the date
-    oledDisplay->print("  Steps: ");                         // Also print the number of steps
-    oledDisplay->print(_stepCount);
-
-    // Also draw two lines to separate the top from the bottom
-    oledDisplay->drawLine(0, 45, 130, 45, SSD1306_WHITE);
-    oledDisplay->drawLine(0, 47, 130, 47, SSD1306_WHITE);
-
-    // Draw low battery alert if it's required
-    if(_lowBattery)
+    uint8_t dirtyPages = faceRenderer.render(oledDisplay, _state);
+    if (dirtyPages != 0)
     {
-        oledDisplay->drawBitmap(51, 37, epd_bitmap_low_batt_alert, 23, 12, SSD1306_BLACK, SSD1306_WHITE);
+        // Send it to the display in chunks from the main loop
+        bus->submitFrame(oledDisplay->getBuffer(), dirtyPages);
     }
+}
 
-    oledDisplay->display(); // Show everything on the display
+/**
+ * @brief Switch to the next watch face, it's drawn on the next call to drawFace
+ *
+ */
+void Display::nextFace()
+{
+    currentFace = (currentFace + 1) % FACE_COUNT;
+    faceRenderer.setFace(faces[currentFace]);
 }
 
 /**
@@ -102,7 +98,7 @@ void Display::drawUpdatingRtcIndicator()
     oledDisplay->drawRect(0, 0, 128, 64, SSD1306_WHITE);
     oledDisplay->drawRect(2, 2, 128, 64, SSD1306_WHITE);
 
-    oledDisplay->display(); // Show everything on the display
+    flush(); // Show everything on the display
 }
 
 /**
@@ -127,7 +123,7 @@ void Display::drawErrorMessage(const char *_error)
     oledDisplay->print("Restart via button...");
 
     // Show everything on the display
-    oledDisplay->display();
+    flush();
 }
 
 /**
@@ -156,14 +152,22 @@ void Display::drawMenuPage(uint8_t _menuPageIndex)
     {
         oledDisplay->print(MENU_PAGE_2_TEXT);
     }
+    else if (_menuPageIndex == 3)
+    {
+        oledDisplay->print(MENU_PAGE_3_TEXT);
+    }
+    else if (_menuPageIndex == 4)
+    {
+        oledDisplay->print(MENU_PAGE_4_TEXT);
+    }
     // Add more pages if you want!
     else
     {
-        oledDisplay->print(MENU_PAGE_3_TEXT);
+        oledDisplay->print(MENU_PAGE_5_TEXT);
     }
 
     // Show everything on the display
-    oledDisplay->display();
+    flush();
 }
 
 /**
@@ -180,7 +184,7 @@ void Display::selfDestructMessage(int _secRemaining)
     oledDisplay->setTextSize(1);
     oledDisplay->print("Self destructing in ");
     oledDisplay->print(_secRemaining);
-    oledDisplay->display(); // Show it on the display
+    flush(); // Show it on the display
 }
 
 /**
@@ -197,7 +201,7 @@ void Display::selfDestructEnd()
     oledDisplay->print("Just kidding :)");
     oledDisplay->setCursor(0, 40);
     oledDisplay->print("Implement your custom function here!");
-    oledDisplay->display(); // Show it on the display
+    flush(); // Show it on the display
 }
 
 /**
@@ -206,9 +210,9 @@ void Display::selfDestructEnd()
  * @note  Borrowed from Inkplate 4TEMPERA's gyroscope example!
  *
  * @param _gyro Pointer to the gyroscope object
- * @param button Pointer to the button object, so we know when to exit the function
+ * @param _input Pointer to the input events, so we know when to exit the function
  */
-void Display::gyroAnimation(Soldered_LSM6DS3 *_gyro, RBD::Button *button)
+void Display::gyroAnimation(Soldered_LSM6DS3 *_gyro, Input *_input)
 {
     // Variables which are used for drawing the 3D Cube
 
@@ -286,12 +290,18 @@ void Display::gyroAnimation(Soldered_LSM6DS3 *_gyro, RBD::Button *button)
             oledDisplay->drawLine(x1, y1, x2, y2, SSD1306_WHITE);
         }
 
-        oledDisplay->display();
-        // Wait 30ms so the frame rate isn't too fast
-        delay(30);
+        flush(false);
+        // Wait 30ms so the frame rate isn't too fast, the frame is sent in the meantime
+        // A full frame takes about 30 ms at 400 kHz, so also wait until it's done before drawing the next one
+        uint32_t frameStart = millis();
+        while (millis() - frameStart < 30 || !bus->isIdle())
+        {
+            bus->service(I2C_SERVICE_BUDGET_US);
+            delay(1);
+        }
 
-        // If the button is pressed, exit the function
-        if (button->onPressed())
+        // If the button is pressed or the watch is tapped, exit the function
+        if (_input->pressed())
         {
             return;
         }
@@ -328,9 +338,9 @@ void Display::project(float *v, float angleX, float angleY, float angleZ, int *x
 /**
  * @brief This function scans for wifi networks and prints the results on the display
  *
- * @param button pointer to the button - so we know when to exit the function
+ * @param _input pointer to the input events - so we know when to exit the function
  */
-void Display::wifiScanner(RBD::Button *button)
+void Display::wifiScanner(Input *_input)
 {
     // Let's set up the display for printing
     oledDisplay->clearDisplay();
@@ -340,7 +350,7 @@ void Display::wifiScanner(RBD::Button *button)
 
     // Print text so the users knows what's going on
     oledDisplay->print("Scanning...");
-    oledDisplay->display(); // Show it on the display
+    flush(); // Show it on the display
 
     // Again, prepare the display for printing
     oledDisplay->clearDisplay();
@@ -348,11 +358,11 @@ void Display::wifiScanner(RBD::Button *button)
 
     // Scan for available WiFi networks
     int numNetworks = WiFi.scanNetworks();
-    if (numNetworks == 0)
+    if (numNetworks <= 0)
     {
         // If there are no networks found, just notify the user
         oledDisplay->print("No networks found");
-        oledDisplay->display();
+        flush();
     }
     else
     {
@@ -367,13 +377,16 @@ void Display::wifiScanner(RBD::Button *button)
         // Print all networks but not more than 5
         for (int i = 0; i < numNetworks && i < 5; i++)
         {
+            // Read the name straight from the scan results, WiFi.SSID() would create a String on the heap
+            wifi_ap_record_t *network = (wifi_ap_record_t *)WiFi.getScanInfoByIndex(i);
+
             // If the WiFi name is empty, skip it!
-            if (WiFi.SSID(i).length() == 0)
+            if (network == nullptr || network->ssid[0] == '\0')
                 continue;
 
             // Print the WiFi name (SSID)
-            oledDisplay->print(WiFi.SSID(i));
-            oledDisplay->display();
+            oledDisplay->print((const char *)network->ssid);
+            flush();
 
             // Manually go to new line
             oledDisplay->setCursor(0, 20 + 10 * i);
@@ -385,13 +398,130 @@ void Display::wifiScanner(RBD::Button *button)
         oledDisplay->setTextWrap(true);
     }
 
+    // Free the scan results, they were allocated by the WiFi driver
+    WiFi.scanDelete();
+
     // Now wait for user input
     while (true)
     {
-        // If the button is pressed, exit the function
-        if (button->onPressed())
+        // If the button is pressed or the watch is tapped, exit the function
+        if (_input->pressed())
         {
             return;
         }
     }
 }
+
+
+/**
+ * @brief This function shows the received notifications, the text of each one scrolls across the display like a ticker
+ *
+ * @note  Press the button or tap the watch to go to the next (older) notification. The function returns after the
+ *        last one or when there was no input for NOTIF_TICKER_TIMEOUT_MS
+ *
+ * @param _notifications Pointer to the notifications buffer
+ * @param _input Pointer to the input events, so we know when to go to the next notification
+ */
+void Display::notificationTicker(Notifications *_notifications, Input *_input)
+{
+    uint8_t index = 0;              // Which notification is shown, 0 is the newest
+    int16_t scrollX = OLED_WIDTH;   // The ticker text starts off screen on the right
+    uint32_t lastInput = millis();  // For the timeout
+
+    // Everything is going to be shown now
+    _notifications->markAllRead();
+
+    // Text wrapping would break the ticker
+    oledDisplay->setTextWrap(false);
+    oledDisplay->setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+
+    while (true)
+    {
+        // Keep receiving while the ticker runs, jump to the newest one if something arrived
+        if (_notifications->poll())
+        {
+            _notifications->markAllRead();
+            index = 0;
+            scrollX = OLED_WIDTH;
+        }
+
+        oledDisplay->clearDisplay();
+        oledDisplay->setTextSize(1);
+        oledDisplay->setCursor(0, 0);
+
+        const Notification *notification = _notifications->get(index);
+        if (notification == nullptr)
+        {
+            oledDisplay->print("No notifications");
+        }
+        else
+        {
+            // Print the header, which one this is, how important it is and how many times it was received
+            oledDisplay->print(index + 1);
+            oledDisplay->print("/");
+            oledDisplay->print(_notifications->count());
+            if (notification->priority == NOTIF_PRIORITY_HIGH)
+            {
+                oledDisplay->print("  URGENT");
+            }
+            if (notification->repeatCount > 1)
+            {
+                oledDisplay->print("  x");
+                oledDisplay->print(notification->repeatCount);
+            }
+            oledDisplay->drawLine(0, 10, 127, 10, SSD1306_WHITE);
+
+            // Draw the ticker in large font and move it a bit to the left for the next frame
+            oledDisplay->setTextSize(2);
+            oledDisplay->setCursor(scrollX, 28);
+            oledDisplay->print(notification->text);
+            scrollX -= 3;
+            if (scrollX < -(int16_t)(strlen(notification->text) * 12))
+            {
+                scrollX = OLED_WIDTH;
+            }
+        }
+
+        flush();
+        // Wait 30ms so the text doesn't scroll too fast
+        delay(30);
+
+        // Go to the next notification on any input, exit after the last one
+        if (_input->pressed())
+        {
+            lastInput = millis();
+            index++;
+            scrollX = OLED_WIDTH;
+            if (index >= _notifications->count())
+            {
+                break;
+            }
+        }
+
+        if (millis() - lastInput > NOTIF_TICKER_TIMEOUT_MS)
+        {
+            break;
+        }
+    }
+
+    // Put the text settings back
+    oledDisplay->setTextSize(1);
+    oledDisplay->setTextWrap(true);
+}
+
+/**
+ * @brief Send the frame buffer to the display through the I2C queue
+ *
+ * @param _wait If true, wait until the whole frame is sent, otherwise it's sent as the queue is serviced
+ */
+void Display::flush(bool _wait)
+{
+    // Something other than the watch face was drawn, so it has to be fully drawn next time
+    faceRenderer.invalidate();
+
+    bus->submitFrame(oledDisplay->getBuffer(), 0xFF);
+    if (_wait)
+    {
+        bus->drain();
+    }
+}
\ No newline at end of file
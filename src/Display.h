@@ -1,36 +1,50 @@
 #ifndef __SMART_WATCH_DISPLAY__
 #define __SMART_WATCH_DISPLAY__
 
+#include "FaceRenderer.h"
+#include "I2cQueue.h"
+#include "Input.h"
+#include "defines.h"
 #include "LSM6DS3-SOLDERED.h"
+#include "Notifications.h"
 #include "OLED-Display-SOLDERED.h"
 #include "time.h"
-#include <RBD_Button.h>
-#include <RBD_Timer.h>
 
 class Display
 {
   public:
-    Display() : oledDisplay(nullptr)
+    Display() : oledDisplay(nullptr), bus(nullptr), currentFace(0)
     {
-    } // Constructor initializes oledDisplay to nullptr
+    } // Constructor initializes oledDisplay and bus to nullptr
     ~Display()
     {
         // Destructor to clean up and avoid memory leaks
+#if STATIC_ALLOCATION
+        if (oledDisplay != nullptr)
+            oledDisplay->~OLED_Display();
+#else
         delete oledDisplay;
+#endif
     }
-    bool begin();
+    bool begin(I2cQueue *_bus);
     void showLoadingMessage(const char *_message);
-    void drawTimeAndStepCount(time_t _currentTime, uint32_t _stepCount, bool _lowBattery);
+    void drawFace(const FaceState *_state);
+    void nextFace();
     void drawUpdatingRtcIndicator();
     void drawErrorMessage(const char *_error);
     void drawMenuPage(uint8_t _menuPageIndex);
     void selfDestructMessage(int _secRemaining);
     void selfDestructEnd();
-    void gyroAnimation(Soldered_LSM6DS3 *_gyro, RBD::Button *button);
-    void wifiScanner(RBD::Button *button);
+    void gyroAnimation(Soldered_LSM6DS3 *_gyro, Input *_input);
+    void wifiScanner(Input *_input);
+    void notificationTicker(Notifications *_notifications, Input *_input);
 
   private:
     OLED_Display *oledDisplay;
+    I2cQueue *bus;
+    FaceRenderer faceRenderer;
+    uint8_t currentFace;
+    void flush(bool _wait = true);
     void project(float *v, float angleX, float angleY, float angleZ, int *x, int *y);
 };
 
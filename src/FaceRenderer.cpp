@@ -0,0 +1,372 @@
+#include "FaceRenderer.h"
+#include "images.h"
+
+static_assert(FACE_MAX_ITEMS <= 32, "Face items must fit in a 32 bit mask");
+
+// Size of the low battery bitmap from images.h
+#define FACE_ICON_WIDTH  23
+#define FACE_ICON_HEIGHT 12
+
+static const char *const weekdayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+
+/**
+ * @brief Construct a new FaceRenderer:: FaceRenderer object
+ *
+ */
+FaceRenderer::FaceRenderer() : numItems(0), valid(false)
+{
+}
+
+/**
+ * @brief Select the face to render, it will be fully drawn on the next render
+ *
+ * @param _program the face program, check Faces.h
+ */
+void FaceRenderer::setFace(const uint8_t *_program)
+{
+    // Decode the program once, so rendering doesn't have to walk it
+    numItems = 0;
+    for (const uint8_t *pc = _program; pgm_read_byte(pc) != FACE_OP_END && numItems < FACE_MAX_ITEMS; numItems++)
+    {
+        uint8_t length = instructionLength(pgm_read_byte(pc));
+        for (int i = 0; i < length; i++)
+        {
+            items[numItems][i] = pgm_read_byte(pc++);
+        }
+    }
+    valid = false;
+}
+
+/**
+ * @brief Call this when something else was drawn on the display, so the face is fully drawn on the next render
+ *
+ */
+void FaceRenderer::invalidate()
+{
+    valid = false;
+}
+
+/**
+ * @brief Draw the widgets whose value changed since the last render
+ *
+ * @note  Changed widgets are cleared first. Everything which overlaps a cleared area is then drawn again, and so is
+ *        everything which overlaps that, in program order, so the result is the same as drawing the whole face
+ *
+ * @param _display the display to draw into, only the frame buffer is changed
+ * @param _state the values to show
+ * @return uint8_t one bit per display page which changed, 0 if nothing has to be sent to the display
+ */
+uint8_t FaceRenderer::render(OLED_Display *_display, const FaceState *_state)
+{
+    struct tm timeinfo;
+    localtime_r(&_state->time, &timeinfo);
+
+    // Find the widgets whose value changed
+    uint32_t redraw = 0;
+    for (int i = 0; i < numItems; i++)
+    {
+        uint8_t op = items[i][0];
+        if (op != FACE_OP_TEXT && op != FACE_OP_ICON && op != FACE_OP_BAR)
+        {
+            // Shapes never change
+            continue;
+        }
+
+        // The bind is always the last argument, bars are filled inside their outline
+        uint8_t bind = items[i][instructionLength(op) - 1];
+        uint32_t value = bindValue(bind, _state, &timeinfo, op == FACE_OP_BAR ? items[i][3] - 2 : 0);
+        if (!valid || value != cachedValues[i])
+        {
+            cachedValues[i] = value;
+            redraw |= 1UL << i;
+        }
+    }
+
+    if (!valid)
+    {
+        // Draw everything
+        _display->clearDisplay();
+        redraw = numItems == 32 ? UINT32_MAX : (1UL << numItems) - 1;
+    }
+    else if (redraw == 0)
+    {
+        // Nothing changed
+        return 0;
+    }
+    else
+    {
+        // Clear the widgets which changed
+        for (int i = 0; i < numItems; i++)
+        {
+            if (redraw & (1UL << i))
+            {
+                int16_t x, y, width, height;
+                itemArea(i, &x, &y, &width, &height);
+                _display->fillRect(x, y, width, height, SSD1306_BLACK);
+            }
+        }
+
+        // Add everything overlapping something which is going to be drawn, until nothing more is added
+        bool added = true;
+        while (added)
+        {
+            added = false;
+            for (int i = 0; i < numItems; i++)
+            {
+                for (int j = 0; j < numItems && !(redraw & (1UL << i)); j++)
+                {
+                    if ((redraw & (1UL << j)) && itemsOverlap(i, j))
+                    {
+                        redraw |= 1UL << i;
+                        added = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // Draw in program order and remember which pages were touched
+    uint8_t dirtyPages = 0;
+    _display->setTextWrap(false);
+    _display->setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+    for (int i = 0; i < numItems; i++)
+    {
+        if (!(redraw & (1UL << i)))
+        {
+            continue;
+        }
+        drawItem(_display, i, _state, &timeinfo);
+
+        int16_t x, y, width, height;
+        itemArea(i, &x, &y, &width, &height);
+        for (int page = y / 8; page <= (y + height - 1) / 8 && page < OLED_HEIGHT / 8; page++)
+        {
+            dirtyPages |= 1 << page;
+        }
+    }
+
+    // Put the text settings back
+    _display->setTextSize(1);
+    _display->setTextWrap(true);
+
+    // After a full draw, the whole frame has to be sent
+    if (!valid)
+    {
+        dirtyPages = 0xFF;
+    }
+    valid = true;
+    return dirtyPages;
+}
+
+/**
+ * @brief Get the value a widget shows, widgets are only drawn again when this changes
+ *
+ * @param _barWidth for bars, the number of pixels the bar can fill
+ */
+uint32_t FaceRenderer::bindValue(uint8_t _bind, const FaceState *_state, struct tm *_timeinfo, uint8_t _barWidth)
+{
+    switch (_bind)
+    {
+    case FACE_BIND_TIME:
+        return _timeinfo->tm_hour * 60 + _timeinfo->tm_min;
+    case FACE_BIND_DATE:
+        return _timeinfo->tm_mon * 100 + _timeinfo->tm_mday;
+    case FACE_BIND_WEEKDAY:
+        return _timeinfo->tm_wday;
+    case FACE_BIND_STEPS:
+    case FACE_BIND_STEP_COUNT:
+        return _state->steps;
+    case FACE_BIND_STEP_GOAL:
+        // The number of filled pixels, so the bar is only drawn again when it visibly changes
+        return _state->steps >= STEP_GOAL ? _barWidth : _state->steps * _barWidth / STEP_GOAL;
+    case FACE_BIND_LOW_BATTERY:
+        return _state->lowBattery;
+    case FACE_BIND_SYNC:
+        return _state->syncFailed;
+    case FACE_BIND_CADENCE:
+        return _state->cadence;
+    case FACE_BIND_CADENCE_LONG:
+        return _state->cadenceLong;
+    case FACE_BIND_DISTANCE:
+        // Only the shown precision, 10 m
+        return _state->distanceMeters / 10;
+    case FACE_BIND_CALORIES:
+        return _state->calories;
+    case FACE_BIND_ACTIVE_MINUTES:
+        return _state->activeMinutes;
+    case FACE_BIND_STREAK:
+        return _state->longestStreak;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Print the text of a text widget
+ *
+ * @param _text buffer for the text, at least 24 characters
+ * @param _maxChars the text is cut to this length
+ */
+void FaceRenderer::formatText(uint8_t _bind, const FaceState *_state, struct tm *_timeinfo, char *_text,
+                              uint8_t _maxChars)
+{
+    switch (_bind)
+    {
+    case FACE_BIND_TIME:
+        sprintf(_text, "%02d:%02d", _timeinfo->tm_hour, _timeinfo->tm_min);
+        break;
+    case FACE_BIND_DATE:
+        sprintf(_text, "%02d.%02d.", _timeinfo->tm_mday, _timeinfo->tm_mon + 1);
+        break;
+    case FACE_BIND_WEEKDAY:
+        sprintf(_text, "%s", weekdayNames[_timeinfo->tm_wday % 7]);
+        break;
+    case FACE_BIND_STEPS:
+        sprintf(_text, "Steps: %lu", (unsigned long)_state->steps);
+        break;
+    case FACE_BIND_STEP_COUNT:
+        sprintf(_text, "%lu", (unsigned long)_state->steps);
+        break;
+    case FACE_BIND_SYNC:
+        sprintf(_text, "%s", _state->syncFailed ? "!sync" : "");
+        break;
+    case FACE_BIND_CADENCE:
+        sprintf(_text, "%u spm", _state->cadence);
+        break;
+    case FACE_BIND_CADENCE_LONG:
+        sprintf(_text, "10m avg %u spm", _state->cadenceLong);
+        break;
+    case FACE_BIND_DISTANCE:
+        sprintf(_text, "%lu.%02lu km", (unsigned long)(_state->distanceMeters / 1000),
+                (unsigned long)(_state->distanceMeters % 1000 / 10));
+        break;
+    case FACE_BIND_CALORIES:
+        sprintf(_text, "%lu kcal", (unsigned long)_state->calories);
+        break;
+    case FACE_BIND_ACTIVE_MINUTES:
+        sprintf(_text, "Active %um", _state->activeMinutes);
+        break;
+    case FACE_BIND_STREAK:
+        sprintf(_text, "Best %um", _state->longestStreak);
+        break;
+    default:
+        _text[0] = '\0';
+        break;
+    }
+
+    // Cut it so it doesn't draw outside of the widget area
+    if (_maxChars < 23)
+    {
+        _text[_maxChars] = '\0';
+    }
+}
+
+/**
+ * @brief Draw one item of the face
+ *
+ */
+void FaceRenderer::drawItem(OLED_Display *_display, uint8_t _item, const FaceState *_state, struct tm *_timeinfo)
+{
+    const uint8_t *instruction = items[_item];
+    if (instruction[0] == FACE_OP_LINE)
+    {
+        _display->drawLine(instruction[1], instruction[2], instruction[3], instruction[4], SSD1306_WHITE);
+    }
+    else if (instruction[0] == FACE_OP_RECT)
+    {
+        _display->drawRect(instruction[1], instruction[2], instruction[3], instruction[4], SSD1306_WHITE);
+    }
+    else if (instruction[0] == FACE_OP_TEXT)
+    {
+        char text[24];
+        formatText(instruction[5], _state, _timeinfo, text, instruction[4]);
+        _display->setTextSize(instruction[3]);
+        _display->setCursor(instruction[1], instruction[2]);
+        _display->print(text);
+    }
+    else if (instruction[0] == FACE_OP_ICON)
+    {
+        // Only draw the icon while its flag is set
+        if (cachedValues[_item])
+        {
+            _display->drawBitmap(instruction[1], instruction[2], epd_bitmap_low_batt_alert, FACE_ICON_WIDTH,
+                                 FACE_ICON_HEIGHT, SSD1306_BLACK, SSD1306_WHITE);
+        }
+    }
+    else if (instruction[0] == FACE_OP_BAR)
+    {
+        // Outline, then fill it as far as the value goes
+        _display->drawRect(instruction[1], instruction[2], instruction[3], instruction[4], SSD1306_WHITE);
+        _display->fillRect(instruction[1] + 1, instruction[2] + 1, cachedValues[_item], instruction[4] - 2,
+                           SSD1306_WHITE);
+    }
+}
+
+/**
+ * @brief Get the area of the display an item draws into
+ *
+ */
+void FaceRenderer::itemArea(uint8_t _item, int16_t *_x, int16_t *_y, int16_t *_width, int16_t *_height)
+{
+    const uint8_t *instruction = items[_item];
+    *_x = instruction[1];
+    *_y = instruction[2];
+    if (instruction[0] == FACE_OP_LINE)
+    {
+        // The endpoints can be in any order
+        *_x = min(instruction[1], instruction[3]);
+        *_y = min(instruction[2], instruction[4]);
+        *_width = abs(instruction[3] - instruction[1]) + 1;
+        *_height = abs(instruction[4] - instruction[2]) + 1;
+    }
+    else if (instruction[0] == FACE_OP_TEXT)
+    {
+        // Characters are 6x8 pixels at text size 1
+        *_width = instruction[4] * 6 * instruction[3];
+        *_height = 8 * instruction[3];
+    }
+    else if (instruction[0] == FACE_OP_ICON)
+    {
+        *_width = FACE_ICON_WIDTH;
+        *_height = FACE_ICON_HEIGHT;
+    }
+    else
+    {
+        *_width = instruction[3];
+        *_height = instruction[4];
+    }
+}
+
+/**
+ * @brief Check if the areas of two items overlap
+ *
+ */
+bool FaceRenderer::itemsOverlap(uint8_t _first, uint8_t _second)
+{
+    int16_t x1, y1, width1, height1, x2, y2, width2, height2;
+    itemArea(_first, &x1, &y1, &width1, &height1);
+    itemArea(_second, &x2, &y2, &width2, &height2);
+    return x1 < x2 + width2 && x2 < x1 + width1 && y1 < y2 + height2 && y2 < y1 + height1;
+}
+
+/**
+ * @brief Get the length of an instruction in bytes, including the opcode
+ *
+ */
+uint8_t FaceRenderer::instructionLength(uint8_t _op)
+{
+    switch (_op)
+    {
+    case FACE_OP_LINE:
+    case FACE_OP_RECT:
+        return 5;
+    case FACE_OP_TEXT:
+        return 6;
+    case FACE_OP_ICON:
+        return 4;
+    case FACE_OP_BAR:
+        return 6;
+    default:
+        return 1;
+    }
+}
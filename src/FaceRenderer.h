@@ -0,0 +1,79 @@
+#ifndef __SMART_WATCH_FACE_RENDERER__
+#define __SMART_WATCH_FACE_RENDERER__
+
+#include "OLED-Display-SOLDERED.h"
+#include "defines.h"
+#include "time.h"
+
+// Watch faces are small programs, each instruction is an opcode followed by its arguments, one byte each
+// Write faces with the FACE_* macros below, the compiler turns them into the byte array, check Faces.h
+#define FACE_OP_END  0 // End of the face
+#define FACE_OP_LINE 1 // Static line: x0, y0, x1, y1
+#define FACE_OP_RECT 2 // Static rectangle outline: x, y, width, height
+#define FACE_OP_TEXT 3 // Text bound to a value: x, y, text size, max characters, bind
+#define FACE_OP_ICON 4 // Bitmap shown when a flag is set: x, y, bind
+#define FACE_OP_BAR  5 // Progress bar: x, y, width, height, bind
+
+// The longest instruction is an opcode with 5 arguments
+#define FACE_MAX_INSTRUCTION_LENGTH 6
+
+// Values which widgets can be bound to
+#define FACE_BIND_TIME           0  // HH:MM
+#define FACE_BIND_DATE           1  // DD.MM.
+#define FACE_BIND_WEEKDAY        2  // Mon, Tue...
+#define FACE_BIND_STEPS          3  // Steps: N
+#define FACE_BIND_STEP_COUNT     4  // N
+#define FACE_BIND_STEP_GOAL      5  // Steps relative to STEP_GOAL, for bars
+#define FACE_BIND_LOW_BATTERY    6  // Low battery flag, for icons
+#define FACE_BIND_SYNC           7  // Shows "!sync" if the last time sync failed
+#define FACE_BIND_CADENCE        8  // Steps in the last minute
+#define FACE_BIND_CADENCE_LONG   9  // Average steps per minute over the last 10 minutes
+#define FACE_BIND_DISTANCE       10 // Distance walked today
+#define FACE_BIND_CALORIES       11 // Calories burned today
+#define FACE_BIND_ACTIVE_MINUTES 12 // Active minutes today
+#define FACE_BIND_STREAK         13 // Longest streak of active minutes today
+
+#define FACE_LINE(x0, y0, x1, y1)             FACE_OP_LINE, x0, y0, x1, y1
+#define FACE_RECT(x, y, width, height)        FACE_OP_RECT, x, y, width, height
+#define FACE_TEXT(x, y, size, maxChars, bind) FACE_OP_TEXT, x, y, size, maxChars, bind
+#define FACE_ICON(x, y, bind)                 FACE_OP_ICON, x, y, bind
+#define FACE_BAR(x, y, width, height, bind)   FACE_OP_BAR, x, y, width, height, bind
+#define FACE_END                              FACE_OP_END
+
+// Everything a face can show
+struct FaceState
+{
+    time_t time;
+    uint32_t steps;
+    bool lowBattery;
+    bool syncFailed;
+    uint16_t cadence;
+    uint16_t cadenceLong;
+    uint32_t distanceMeters;
+    uint32_t calories;
+    uint16_t activeMinutes;
+    uint16_t longestStreak;
+};
+
+class FaceRenderer
+{
+  public:
+    FaceRenderer();
+    void setFace(const uint8_t *_program);
+    void invalidate();
+    uint8_t render(OLED_Display *_display, const FaceState *_state);
+
+  private:
+    uint8_t items[FACE_MAX_ITEMS][FACE_MAX_INSTRUCTION_LENGTH]; // The decoded face program
+    uint8_t numItems;
+    bool valid;                            // False if the whole face has to be drawn again
+    uint32_t cachedValues[FACE_MAX_ITEMS]; // The value each widget shows right now
+    uint32_t bindValue(uint8_t _bind, const FaceState *_state, struct tm *_timeinfo, uint8_t _barWidth);
+    void formatText(uint8_t _bind, const FaceState *_state, struct tm *_timeinfo, char *_text, uint8_t _maxChars);
+    void drawItem(OLED_Display *_display, uint8_t _item, const FaceState *_state, struct tm *_timeinfo);
+    void itemArea(uint8_t _item, int16_t *_x, int16_t *_y, int16_t *_width, int16_t *_height);
+    bool itemsOverlap(uint8_t _first, uint8_t _second);
+    uint8_t instructionLength(uint8_t _op);
+};
+
+#endif
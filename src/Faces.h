@@ -0,0 +1,64 @@
+#ifndef __SMART_WATCH_FACES__
+#define __SMART_WATCH_FACES__
+
+#include "FaceRenderer.h"
+
+// Watch faces, select them from the menu
+// Each face is a list of shapes and widgets, check FaceRenderer.h for what they do
+// Widgets drawn later in the list are drawn on top of the earlier ones
+
+// The original face, big time, date and step count below
+const uint8_t faceClassic[] PROGMEM = {
+    FACE_TEXT(5, 9, 4, 5, FACE_BIND_TIME),
+    FACE_LINE(0, 45, 130, 45),
+    FACE_LINE(0, 47, 130, 47),
+    FACE_TEXT(2, 54, 1, 6, FACE_BIND_DATE),
+    FACE_TEXT(50, 54, 1, 12, FACE_BIND_STEPS),
+    FACE_TEXT(98, 0, 1, 5, FACE_BIND_SYNC),
+    FACE_ICON(51, 37, FACE_BIND_LOW_BATTERY),
+    FACE_END,
+};
+
+// Activity face, big step count and a bar showing the progress to STEP_GOAL
+const uint8_t faceSteps[] PROGMEM = {
+    FACE_TEXT(0, 0, 2, 5, FACE_BIND_TIME),
+    FACE_TEXT(68, 0, 1, 3, FACE_BIND_WEEKDAY),
+    FACE_TEXT(92, 0, 1, 6, FACE_BIND_DATE),
+    FACE_TEXT(68, 8, 1, 5, FACE_BIND_SYNC),
+    FACE_TEXT(0, 24, 3, 5, FACE_BIND_STEP_COUNT),
+    FACE_ICON(100, 30, FACE_BIND_LOW_BATTERY),
+    FACE_BAR(0, 52, 128, 12, FACE_BIND_STEP_GOAL),
+    FACE_END,
+};
+
+// Activity statistics for today
+const uint8_t faceActivity[] PROGMEM = {
+    FACE_TEXT(0, 0, 2, 5, FACE_BIND_TIME),
+    FACE_TEXT(68, 0, 1, 6, FACE_BIND_DATE),
+    FACE_TEXT(68, 8, 1, 5, FACE_BIND_SYNC),
+    FACE_LINE(0, 18, 127, 18),
+    FACE_TEXT(0, 22, 1, 12, FACE_BIND_STEPS),
+    FACE_TEXT(80, 22, 1, 8, FACE_BIND_CADENCE),
+    FACE_TEXT(0, 32, 1, 10, FACE_BIND_DISTANCE),
+    FACE_TEXT(68, 32, 1, 10, FACE_BIND_CALORIES),
+    FACE_TEXT(0, 42, 1, 11, FACE_BIND_ACTIVE_MINUTES),
+    FACE_TEXT(74, 42, 1, 9, FACE_BIND_STREAK),
+    FACE_TEXT(0, 52, 1, 15, FACE_BIND_CADENCE_LONG),
+    FACE_ICON(105, 0, FACE_BIND_LOW_BATTERY),
+    FACE_END,
+};
+
+// Just the time and date
+const uint8_t faceMinimal[] PROGMEM = {
+    FACE_TEXT(5, 16, 4, 5, FACE_BIND_TIME),
+    FACE_TEXT(46, 54, 1, 6, FACE_BIND_DATE),
+    FACE_TEXT(98, 54, 1, 5, FACE_BIND_SYNC),
+    FACE_ICON(0, 52, FACE_BIND_LOW_BATTERY),
+    FACE_END,
+};
+
+// All faces, in the order the menu goes through them
+const uint8_t *const faces[] = {faceClassic, faceSteps, faceActivity, faceMinimal};
+#define FACE_COUNT (sizeof(faces) / sizeof(faces[0]))
+
+#endif
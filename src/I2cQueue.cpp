@@ -0,0 +1,260 @@
+#include "I2cQueue.h"
+#include <Wire.h>
+
+static_assert(OLED_WIDTH % I2C_DISPLAY_CHUNK_BYTES == 0, "Display chunks must not cross pages");
+static_assert(I2C_FRAME_CHUNKS <= 32, "Display chunks must fit in the pendingChunks bitmask");
+
+// SSD1306 control bytes, see the datasheet chapter 8.1.5.2
+#define SSD1306_CONTROL_COMMAND 0x80 // Co = 1, D/C = 0: one command byte follows, then another control byte
+#define SSD1306_CONTROL_DATA    0x40 // Co = 0, D/C = 1: the rest of the transaction is display data
+#define SSD1306_COLUMN_ADDRESS  0x21
+#define SSD1306_PAGE_ADDRESS    0x22
+
+/**
+ * @brief Construct a new I2cQueue:: I2cQueue object
+ *
+ */
+I2cQueue::I2cQueue()
+    : readHead(0), readCount(0), frameBuffer(nullptr), pendingChunks(0), nextChunk(0), frameSubmittedAt(0),
+      statsStart(0), busyUs(0), numReads(0), numReadFailures(0), numChunks(0), numChunkFailures(0), readLatencySum(0),
+      readLatencyMax(0), frameLatencyMax(0)
+{
+}
+
+/**
+ * @brief Set the bus speed and start measuring
+ *
+ * @note  Call this after the display and the gyro were initialized, as both libraries start Wire on their own
+ *
+ * @param _clockHz the I2C clock, 400000 for Fast-mode, 1000000 for Fast-mode Plus
+ */
+void I2cQueue::begin(uint32_t _clockHz)
+{
+    Wire.setClock(_clockHz);
+    statsStart = micros();
+}
+
+/**
+ * @brief Queue a read of consecutive registers
+ *
+ * @param _address I2C address of the device
+ * @param _reg the first register to read, the device has to auto-increment the address
+ * @param _length the number of bytes to read, up to I2C_MAX_READ_BYTES
+ * @param _callback called from service() when the read is done
+ * @param _context passed to the callback
+ * @return true if it was queued
+ * @return false if the queue is full or the read is too long
+ */
+bool I2cQueue::readRegisters(uint8_t _address, uint8_t _reg, uint8_t _length, I2cReadCallback _callback,
+                             void *_context)
+{
+    if (readCount >= I2C_QUEUE_LENGTH || _length > I2C_MAX_READ_BYTES)
+    {
+        return false;
+    }
+
+    I2cRead *read = &reads[(readHead + readCount) % I2C_QUEUE_LENGTH];
+    read->address = _address;
+    read->reg = _reg;
+    read->length = _length;
+    read->callback = _callback;
+    read->context = _context;
+    read->enqueuedAt = micros();
+    readCount++;
+    return true;
+}
+
+/**
+ * @brief Queue the display frame buffer to be sent
+ *
+ * @note  The buffer isn't copied, chunks are sent from it as they come up. If a frame is still being sent, the new
+ *        pages are simply added to it, as the buffer always holds the latest content
+ *
+ * @param _frameBuffer the SSD1306 frame buffer
+ * @param _pageMask one bit per display page (8 pixel rows) which has to be sent
+ */
+void I2cQueue::submitFrame(const uint8_t *_frameBuffer, uint8_t _pageMask)
+{
+    if (pendingChunks == 0)
+    {
+        frameSubmittedAt = micros();
+    }
+    frameBuffer = _frameBuffer;
+
+    for (int page = 0; page < OLED_HEIGHT / 8; page++)
+    {
+        if (_pageMask & (1 << page))
+        {
+            pendingChunks |= ((1UL << I2C_CHUNKS_PER_PAGE) - 1) << (page * I2C_CHUNKS_PER_PAGE);
+        }
+    }
+}
+
+/**
+ * @brief Check if there is nothing left to do on the bus
+ *
+ */
+bool I2cQueue::isIdle()
+{
+    return readCount == 0 && pendingChunks == 0;
+}
+
+/**
+ * @brief Run queued transactions, call this often from the main loop
+ *
+ * @note  Sensor reads are always run first, so a read queued in the meantime goes in between two display chunks.
+ *        Each transaction blocks on the ESP32 I2C driver, which is interrupt driven, so other tasks (WiFi) keep
+ *        running while the bus is busy
+ *
+ * @param _budgetUs how long to keep running transactions, at least one is always run
+ */
+void I2cQueue::service(uint32_t _budgetUs)
+{
+    uint32_t start = micros();
+    do
+    {
+        if (readCount > 0)
+        {
+            runRead();
+        }
+        else if (pendingChunks != 0)
+        {
+            // Send the next pending chunk after the last one sent, so resubmitted frames can't starve the last chunks
+            uint8_t chunk = nextChunk;
+            while (!(pendingChunks & (1UL << chunk)))
+            {
+                chunk = (chunk + 1) % I2C_FRAME_CHUNKS;
+            }
+            nextChunk = (chunk + 1) % I2C_FRAME_CHUNKS;
+            sendChunk(chunk);
+        }
+        else
+        {
+            return;
+        }
+    } while (micros() - start < _budgetUs);
+}
+
+/**
+ * @brief Run everything which is queued, for code which has to wait for the display anyway
+ *
+ */
+void I2cQueue::drain()
+{
+    while (!isIdle())
+    {
+        service(UINT32_MAX);
+    }
+}
+
+/**
+ * @brief Print bus utilization and queue latency since the last report on the debug Serial
+ *
+ */
+void I2cQueue::printStats()
+{
+    uint32_t elapsed = micros() - statsStart;
+    char report[160];
+    snprintf(report, sizeof(report),
+             "I2C: %lu%% busy, %lu reads (%lu failed), %lu chunks (%lu failed), read latency avg %lu us max %lu us, "
+             "frame max %lu us",
+             (unsigned long)(elapsed ? (uint64_t)busyUs * 100 / elapsed : 0), (unsigned long)numReads,
+             (unsigned long)numReadFailures, (unsigned long)numChunks, (unsigned long)numChunkFailures,
+             (unsigned long)(numReads ? readLatencySum / numReads : 0), (unsigned long)readLatencyMax,
+             (unsigned long)frameLatencyMax);
+    DEBUG_PRINT(report);
+
+    // Start a new measurement window
+    statsStart = micros();
+    busyUs = 0;
+    numReads = 0;
+    numReadFailures = 0;
+    numChunks = 0;
+    numChunkFailures = 0;
+    readLatencySum = 0;
+    readLatencyMax = 0;
+    frameLatencyMax = 0;
+}
+
+/**
+ * @brief Run the oldest queued read and call its callback
+ *
+ */
+void I2cQueue::runRead()
+{
+    I2cRead *read = &reads[readHead];
+    uint32_t start = micros();
+
+    // Write the register address with a repeated start, then read
+    Wire.beginTransmission(read->address);
+    Wire.write(read->reg);
+    bool success = Wire.endTransmission(false) == 0;
+    if (success)
+    {
+        success = Wire.requestFrom(read->address, read->length) == read->length;
+        for (int i = 0; i < read->length && Wire.available(); i++)
+        {
+            read->data[i] = Wire.read();
+        }
+    }
+
+    // Update the statistics
+    uint32_t end = micros();
+    uint32_t latency = end - read->enqueuedAt;
+    busyUs += end - start;
+    numReads++;
+    numReadFailures += success ? 0 : 1;
+    readLatencySum += latency;
+    if (latency > readLatencyMax)
+    {
+        readLatencyMax = latency;
+    }
+
+    // Free the slot before the callback, so the callback can queue the next read
+    readHead = (readHead + 1) % I2C_QUEUE_LENGTH;
+    readCount--;
+    if (read->callback != nullptr)
+    {
+        read->callback(read->context, read->data, read->length, success);
+    }
+}
+
+/**
+ * @brief Send one chunk of the frame buffer
+ *
+ * @note  The chunk sets its own column and page window in the same transaction, so it doesn't matter what was sent
+ *        to the display in between two chunks
+ *
+ * @param _chunk index of the chunk in the frame
+ */
+void I2cQueue::sendChunk(uint8_t _chunk)
+{
+    uint8_t page = _chunk / I2C_CHUNKS_PER_PAGE;
+    uint8_t column = (_chunk % I2C_CHUNKS_PER_PAGE) * I2C_DISPLAY_CHUNK_BYTES;
+    uint32_t start = micros();
+
+    Wire.beginTransmission(OLED_I2C_ADDRESS);
+    const uint8_t window[] = {SSD1306_CONTROL_COMMAND, SSD1306_COLUMN_ADDRESS,
+                              SSD1306_CONTROL_COMMAND, column,
+                              SSD1306_CONTROL_COMMAND, (uint8_t)(column + I2C_DISPLAY_CHUNK_BYTES - 1),
+                              SSD1306_CONTROL_COMMAND, SSD1306_PAGE_ADDRESS,
+                              SSD1306_CONTROL_COMMAND, page,
+                              SSD1306_CONTROL_COMMAND, page,
+                              SSD1306_CONTROL_DATA};
+    Wire.write(window, sizeof(window));
+    Wire.write(frameBuffer + page * OLED_WIDTH + column, I2C_DISPLAY_CHUNK_BYTES);
+    if (Wire.endTransmission() != 0)
+    {
+        numChunkFailures++;
+    }
+
+    // The chunk is done even if it failed, the next frame will fix it
+    pendingChunks &= ~(1UL << _chunk);
+    uint32_t end = micros();
+    busyUs += end - start;
+    numChunks++;
+    if (pendingChunks == 0 && end - frameSubmittedAt > frameLatencyMax)
+    {
+        frameLatencyMax = end - frameSubmittedAt;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef __SMART_WATCH_I2C_QUEUE__
+#define __SMART_WATCH_I2C_QUEUE__
+
+#include "defines.h"
+#include <Arduino.h>
+
+// The frame buffer is sent in chunks, each chunk is one self-contained I2C transaction
+#define I2C_FRAME_SIZE      (OLED_WIDTH * OLED_HEIGHT / 8)
+#define I2C_CHUNKS_PER_PAGE (OLED_WIDTH / I2C_DISPLAY_CHUNK_BYTES)
+#define I2C_FRAME_CHUNKS    (I2C_FRAME_SIZE / I2C_DISPLAY_CHUNK_BYTES)
+
+// Called when a queued register read is done
+typedef void (*I2cReadCallback)(void *_context, const uint8_t *_data, uint8_t _length, bool _success);
+
+// A queued register read, the data is kept inside so the caller doesn't have to keep a buffer around
+struct I2cRead
+{
+    uint8_t address;
+    uint8_t reg;
+    uint8_t length;
+    uint8_t data[I2C_MAX_READ_BYTES];
+    I2cReadCallback callback;
+    void *context;
+    uint32_t enqueuedAt; // micros() when it was queued, for the latency report
+};
+
+class I2cQueue
+{
+  public:
+    I2cQueue();
+    void begin(uint32_t _clockHz);
+    bool readRegisters(uint8_t _address, uint8_t _reg, uint8_t _length, I2cReadCallback _callback, void *_context);
+    void submitFrame(const uint8_t *_frameBuffer, uint8_t _pageMask);
+    bool isIdle();
+    void service(uint32_t _budgetUs);
+    void drain();
+    void printStats();
+
+  private:
+    I2cRead reads[I2C_QUEUE_LENGTH]; // Sensor reads, they always go before display chunks
+    uint8_t readHead;
+    uint8_t readCount;
+    const uint8_t *frameBuffer;
+    uint32_t pendingChunks; // One bit per frame chunk which still has to be sent
+    uint8_t nextChunk;      // Where to look for the next pending chunk
+    uint32_t frameSubmittedAt;
+
+    // Statistics since the last report
+    uint32_t statsStart;
+    uint32_t busyUs;
+    uint32_t numReads;
+    uint32_t numReadFailures;
+    uint32_t numChunks;
+    uint32_t numChunkFailures;
+    uint32_t readLatencySum;
+    uint32_t readLatencyMax;
+    uint32_t frameLatencyMax;
+
+    void runRead();
+    void sendChunk(uint8_t _chunk);
+};
+
+#endif
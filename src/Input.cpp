@@ -0,0 +1,189 @@
+#include "Input.h"
+#include "LSM6DS3-SOLDERED.h"
+
+// LSM6DS3 TAP_SRC register bits
+#define TAP_SRC_SINGLE_TAP 0x20
+#define TAP_SRC_DOUBLE_TAP 0x10
+
+// Set by the interrupt, read by poll()
+static volatile uint8_t interruptCount = 0;
+static volatile uint32_t interruptTime = 0;
+
+/**
+ * @brief Construct a new Input:: Input object
+ *
+ */
+Input::Input()
+    : button(nullptr), bus(nullptr), eventHead(0), eventCount(0), tapSourceQueued(false), singleTapPending(false),
+      singleTapTime(0), tapTime(0)
+{
+}
+
+/**
+ * @brief Start listening for button presses and gyroscope taps
+ *
+ * @note  The gyroscope has to be configured to signal taps on its INT1 pin, check configGyro()
+ *
+ * @param _button the button, it's polled
+ * @param _bus the I2C queue, used to read which tap happened
+ * @param _interruptPin the GPIO the gyroscope INT1 pin is wired to
+ */
+void Input::begin(RBD::Button *_button, I2cQueue *_bus, uint8_t _interruptPin)
+{
+    button = _button;
+    bus = _bus;
+    // Pulled down, so the pin doesn't float and fire when INT1 isn't wired
+    pinMode(_interruptPin, INPUT_PULLDOWN);
+    attachInterrupt(digitalPinToInterrupt(_interruptPin), onInterrupt, RISING);
+
+    // A tap from before a restart can still be latched, which holds INT1 high so no new interrupt could come
+    // Reading the tap source clears it, the tap itself is old so it's thrown away
+    bus->readRegisters(GYRO_I2C_ADDRESS, LSM6DS3_ACC_GYRO_TAP_SRC, 1, nullptr, nullptr);
+    bus->drain();
+}
+
+/**
+ * @brief Check the button and the gyroscope for new input, call this often
+ *
+ */
+void Input::poll()
+{
+    if (button->onPressed())
+    {
+        push(INPUT_EVENT_BUTTON, millis());
+    }
+
+    // The gyroscope signalled a tap, read which one it was
+    // The interrupt is only cleared once the read is queued, so the tap isn't lost if the queue is full
+    if (interruptCount > 0 && !tapSourceQueued &&
+        bus->readRegisters(GYRO_I2C_ADDRESS, LSM6DS3_ACC_GYRO_TAP_SRC, 1, onTapSourceRead, this))
+    {
+        noInterrupts();
+        tapTime = interruptTime;
+        interruptCount = 0;
+        interrupts();
+
+        tapSourceQueued = true;
+        // Sensor reads go first, so this only waits for the read itself, even during a display flush
+        bus->service(0);
+    }
+
+    // A single tap becomes an event once it's clear it's not the start of a double tap
+    if (singleTapPending && millis() - singleTapTime >= TAP_DOUBLE_WINDOW_MS)
+    {
+        singleTapPending = false;
+        push(INPUT_EVENT_TAP, singleTapTime);
+    }
+}
+
+/**
+ * @brief Take the oldest event from the queue
+ *
+ * @param _event where to store the event
+ * @return true if there was an event
+ * @return false if the queue is empty
+ */
+bool Input::getEvent(InputEvent *_event)
+{
+    if (eventCount == 0)
+    {
+        return false;
+    }
+    *_event = events[eventHead];
+    eventHead = (eventHead + 1) % INPUT_QUEUE_LENGTH;
+    eventCount--;
+    return true;
+}
+
+/**
+ * @brief Poll and check if there was any input at all, for screens which only wait for the user
+ *
+ * @return true if the button was pressed or the watch was tapped
+ */
+bool Input::pressed()
+{
+    poll();
+    InputEvent event;
+    return getEvent(&event);
+}
+
+/**
+ * @brief Print how long it took from the input to the action on the debug Serial
+ *
+ * @param _event the event which caused the action
+ * @param _action what was done
+ */
+void Input::reportLatency(const InputEvent *_event, const char *_action)
+{
+    static const char *const eventNames[] = {"Button", "Tap", "Double tap"};
+    char report[64];
+    snprintf(report, sizeof(report), "%s -> %s: %lu ms", eventNames[_event->type % 3], _action,
+             (unsigned long)(millis() - _event->timestamp));
+    DEBUG_PRINT(report);
+}
+
+/**
+ * @brief Add an event to the queue, it's dropped if the queue is full
+ *
+ */
+void Input::push(uint8_t _type, uint32_t _timestamp)
+{
+    if (eventCount >= INPUT_QUEUE_LENGTH)
+    {
+        return;
+    }
+    events[(eventHead + eventCount) % INPUT_QUEUE_LENGTH] = {_type, _timestamp};
+    eventCount++;
+}
+
+/**
+ * @brief Called by the I2C queue when the tap source register was read
+ *
+ */
+void Input::onTapSourceRead(void *_context, const uint8_t *_data, uint8_t _length, bool _success)
+{
+    Input *input = (Input *)_context;
+    input->tapSourceQueued = false;
+    if (!_success)
+    {
+        // The interrupt stays latched until the register is read, so no new one would come, try again on the next poll
+        noInterrupts();
+        if (interruptCount == 0)
+        {
+            interruptTime = input->tapTime;
+        }
+        interruptCount++;
+        interrupts();
+        return;
+    }
+
+    if (_data[0] & TAP_SRC_DOUBLE_TAP)
+    {
+        // The first tap was already signalled as a single tap, it's part of this one
+        input->singleTapPending = false;
+        input->push(INPUT_EVENT_DOUBLE_TAP, input->tapTime);
+    }
+    else if (_data[0] & TAP_SRC_SINGLE_TAP)
+    {
+        // Hold it back until the double tap window is over
+        if (input->singleTapPending)
+        {
+            input->push(INPUT_EVENT_TAP, input->singleTapTime);
+        }
+        input->singleTapPending = true;
+        input->singleTapTime = input->tapTime;
+    }
+}
+
+/**
+ * @brief Gyroscope INT1 interrupt, only remembers when it happened, the I2C read is done in poll()
+ *
+ */
+void IRAM_ATTR Input::onInterrupt()
+{
+    if (interruptCount == 0)
+    {
+        interruptTime = millis();
+    }
+    interruptCount++;
+}
@@ -0,0 +1,48 @@
+#ifndef __SMART_WATCH_INPUT__
+#define __SMART_WATCH_INPUT__
+
+#include "I2cQueue.h"
+#include "defines.h"
+#include <Arduino.h>
+#include <RBD_Button.h>
+#include <RBD_Timer.h>
+
+// Input event types
+#define INPUT_EVENT_BUTTON     0
+#define INPUT_EVENT_TAP        1
+#define INPUT_EVENT_DOUBLE_TAP 2
+
+// One input event, with the time it happened, not the time it was read
+struct InputEvent
+{
+    uint8_t type;       // One of INPUT_EVENT_*
+    uint32_t timestamp; // millis() when the button or the gyroscope interrupt fired
+};
+
+class Input
+{
+  public:
+    Input();
+    void begin(RBD::Button *_button, I2cQueue *_bus, uint8_t _interruptPin);
+    void poll();
+    bool getEvent(InputEvent *_event);
+    bool pressed();
+    void reportLatency(const InputEvent *_event, const char *_action);
+
+  private:
+    RBD::Button *button;
+    I2cQueue *bus;
+    InputEvent events[INPUT_QUEUE_LENGTH];
+    uint8_t eventHead;
+    uint8_t eventCount;
+    bool tapSourceQueued;  // A read of the tap source register is in the I2C queue
+    bool singleTapPending; // A single tap waits to see if it becomes a double tap
+    uint32_t singleTapTime;
+    uint32_t tapTime; // When the interrupt which is being read fired
+
+    void push(uint8_t _type, uint32_t _timestamp);
+    static void onTapSourceRead(void *_context, const uint8_t *_data, uint8_t _length, bool _success);
+    static void IRAM_ATTR onInterrupt();
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "MemoryMonitor.h"
+#include "esp_heap_caps.h"
+
+// Start and end of the statically allocated RAM, these come from the ESP32 linker script
+extern uint8_t _data_start, _data_end, _bss_start, _bss_end;
+
+// Tasks whose stack watermarks are printed, tasks which don't exist are skipped
+static const char *const watchedTaskNames[] = {"loopTask", "arduino_events", "tiT", "wifi", "IDLE0", "IDLE1"};
+
+// Allocations made by the task which finished setup(), the WiFi driver and the network stack have their own tasks
+// and allocate as they need
+static TaskHandle_t countedTask = nullptr;
+static volatile uint32_t loopAllocations = 0;
+static volatile uint32_t loopAllocatedBytes = 0;
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+/**
+ * @brief Called by the ESP-IDF heap on every allocation from any task, including malloc, realloc and new
+ *
+ */
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void *_pointer, size_t _size, uint32_t _caps)
+{
+    if (countedTask != nullptr && xTaskGetCurrentTaskHandle() == countedTask)
+    {
+        loopAllocations++;
+        loopAllocatedBytes += _size;
+    }
+}
+#endif
+
+/**
+ * @brief Construct a new MemoryMonitor:: MemoryMonitor object
+ *
+ */
+MemoryMonitor::MemoryMonitor()
+    : tracking(false), setupBlocks(0), setupBytes(0), checkedAllocations(0), checkedBytes(0), numAllocatingPasses(0)
+{
+}
+
+/**
+ * @brief Call this at the end of setup(), from now on every allocation made by the calling task is counted
+ *
+ */
+void MemoryMonitor::setupDone()
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    setupBlocks = info.allocated_blocks;
+    setupBytes = info.total_allocated_bytes;
+    loopAllocations = 0;
+    loopAllocatedBytes = 0;
+    countedTask = xTaskGetCurrentTaskHandle();
+    tracking = true;
+}
+
+/**
+ * @brief Call this at the start of loop(), it reports every allocation the last pass made
+ *
+ * @note  The allocations are counted by the ESP-IDF heap hook, so this needs a core built with
+ *        CONFIG_HEAP_USE_HOOKS. Without it nothing is counted on the watch, run make -C test for the host check
+ *
+ * @return true if the last pass allocated memory on the heap
+ */
+bool MemoryMonitor::checkLoop()
+{
+    uint32_t allocations = loopAllocations;
+    uint32_t bytes = loopAllocatedBytes;
+    if (!tracking || allocations == checkedAllocations)
+    {
+        return false;
+    }
+
+    char report[96];
+    snprintf(report, sizeof(report), "ERROR: the main loop allocated %lu times (%lu bytes) on the heap!",
+             (unsigned long)(allocations - checkedAllocations), (unsigned long)(bytes - checkedBytes));
+    DEBUG_PRINT(report);
+    numAllocatingPasses++;
+
+    // Printing doesn't allocate, but don't count it anyway
+    checkedAllocations = loopAllocations;
+    checkedBytes = loopAllocatedBytes;
+    return true;
+}
+
+/**
+ * @brief Print the static, heap and per task stack usage on the debug Serial
+ *
+ */
+void MemoryMonitor::printReport()
+{
+    char report[128];
+
+    // Static RAM is fixed at link time
+    snprintf(report, sizeof(report), "Static: %u bytes data, %u bytes bss", (unsigned)(&_data_end - &_data_start),
+             (unsigned)(&_bss_end - &_bss_start));
+    DEBUG_PRINT(report);
+
+    // The lowest free heap ever shows the peak usage, the largest free block shows fragmentation
+    snprintf(report, sizeof(report), "Heap: %u of %u bytes free, lowest %u, largest block %u",
+             (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getHeapSize(), (unsigned)ESP.getMinFreeHeap(),
+             (unsigned)ESP.getMaxAllocHeap());
+    DEBUG_PRINT(report);
+
+    // The high water mark is the least free stack space the task ever had
+    for (const char *name : watchedTaskNames)
+    {
+        TaskHandle_t task = xTaskGetHandle(name);
+        if (task == nullptr)
+        {
+            continue;
+        }
+        snprintf(report, sizeof(report), "Stack %s: %u bytes never used", name,
+                 (unsigned)uxTaskGetStackHighWaterMark(task));
+        DEBUG_PRINT(report);
+    }
+
+    if (!tracking)
+    {
+        return;
+    }
+
+    // Heap which stayed allocated since setup(), this includes the WiFi and network tasks
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    snprintf(report, sizeof(report), "Heap since setup: %+ld blocks, %+ld bytes",
+             (long)info.allocated_blocks - (long)setupBlocks, (long)info.total_allocated_bytes - (long)setupBytes);
+    DEBUG_PRINT(report);
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+    snprintf(report, sizeof(report), "Main loop allocations after setup: %lu (%lu bytes) in %lu passes",
+             (unsigned long)loopAllocations, (unsigned long)loopAllocatedBytes, (unsigned long)numAllocatingPasses);
+    DEBUG_PRINT(report);
+#else
+    DEBUG_PRINT("Main loop allocations aren't counted, the core was built without CONFIG_HEAP_USE_HOOKS");
+#endif
+}
@@ -0,0 +1,24 @@
+#ifndef __SMART_WATCH_MEMORY_MONITOR__
+#define __SMART_WATCH_MEMORY_MONITOR__
+
+#include "defines.h"
+#include <Arduino.h>
+
+class MemoryMonitor
+{
+  public:
+    MemoryMonitor();
+    void setupDone();
+    bool checkLoop();
+    void printReport();
+
+  private:
+    bool tracking;
+    uint32_t setupBlocks;         // Allocated heap blocks when setup() finished
+    int32_t setupBytes;           // Allocated heap bytes when setup() finished
+    uint32_t checkedAllocations;  // Main loop allocations which were already reported
+    uint32_t checkedBytes;        // Main loop allocated bytes which were already reported
+    uint32_t numAllocatingPasses; // Main loop passes which allocated
+};
+
+#endif
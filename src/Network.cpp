@@ -90,8 +90,13 @@ bool Network::getTimeAndSaveToRTC(const char *_ntpServer, const char *_timezone,
 
     // Set the passed time zone
     // Check zones.csv for which timezones you can pass to this function
-    setenv("TZ", _timezone, 1);
-    tzset();
+    // Only set it if it changed, setenv reallocates the environment on the heap every time
+    const char *currentTimezone = getenv("TZ");
+    if (currentTimezone == nullptr || strcmp(currentTimezone, _timezone) != 0)
+    {
+        setenv("TZ", _timezone, 1);
+        tzset();
+    }
 
     // Now wait until time is set in the RTC
     time_t now = time(nullptr);
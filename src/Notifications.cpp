@@ -0,0 +1,308 @@
+#include "Notifications.h"
+#include "lwip/sockets.h"
+
+// A frame with the longest text has to fit, otherwise it's truncated by recvfrom() and rejected as malformed
+static_assert(NOTIF_RX_BUFFER_SIZE >= NOTIF_HEADER_SIZE + 255, "The receive buffer must hold a whole frame");
+
+/**
+ * @brief Construct a new Notifications:: Notifications object
+ *
+ */
+Notifications::Notifications() : socketFd(-1), numStored(0), numUnread(0), numDropped(0)
+{
+    // Mark all slots as free
+    for (int i = 0; i < NOTIF_CAPACITY; i++)
+    {
+        slots[i].text[0] = '\0';
+    }
+}
+
+/**
+ * @brief Open the UDP socket which listens for notifications
+ *
+ * @note  A raw lwIP socket is used instead of WiFiUDP, this way datagrams are received straight into rxBuffer and
+ *        no heap is allocated per packet
+ *
+ * @param _port the UDP port to listen on
+ * @return true if it was successful
+ * @return false if it failed
+ */
+bool Notifications::begin(uint16_t _port)
+{
+    // Already listening
+    if (socketFd >= 0)
+    {
+        return true;
+    }
+
+    socketFd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socketFd < 0)
+    {
+        return false;
+    }
+
+    // Listen on all interfaces, so the socket survives WiFi reconnects
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(socketFd, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        close(socketFd);
+        socketFd = -1;
+        return false;
+    }
+
+    // Never block the main loop
+    fcntl(socketFd, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+/**
+ * @brief Receive and parse waiting datagrams, call this often from the main loop
+ *
+ * @note  At most NOTIF_MAX_PACKETS_PER_POLL datagrams are handled per call. During a flood the rest waits in the
+ *        lwIP receive mailbox, which is of fixed size, so anything over that is dropped by the network stack itself
+ *
+ * @return uint8_t the number of notifications which were stored or coalesced
+ */
+uint8_t Notifications::poll()
+{
+    if (socketFd < 0)
+    {
+        return 0;
+    }
+
+    uint8_t accepted = 0;
+    for (int packet = 0; packet < NOTIF_MAX_PACKETS_PER_POLL; packet++)
+    {
+        struct sockaddr_in sender;
+        socklen_t senderLength = sizeof(sender);
+        int received =
+            recvfrom(socketFd, rxBuffer, sizeof(rxBuffer), MSG_DONTWAIT, (struct sockaddr *)&sender, &senderLength);
+        if (received <= 0)
+        {
+            // Nothing more waiting
+            break;
+        }
+
+        // Walk the frames in place, the text is only copied once, into its slot
+        uint8_t status = NOTIF_STATUS_MALFORMED;
+        uint8_t sequence = 0;
+        uint8_t statusCounts[NOTIF_STATUS_MALFORMED] = {0};
+        int offset = 0;
+        while (offset + NOTIF_HEADER_SIZE <= received)
+        {
+            const uint8_t *frame = rxBuffer + offset;
+            uint8_t length = frame[5];
+            if (frame[0] != 'S' || frame[1] != 'W' || frame[2] != NOTIF_PROTOCOL_VERSION || length == 0 ||
+                offset + NOTIF_HEADER_SIZE + length > received)
+            {
+                // Broken or truncated frame, ignore the rest of the datagram
+                status = NOTIF_STATUS_MALFORMED;
+                break;
+            }
+
+            sequence = frame[4];
+            uint8_t priority = frame[3] > NOTIF_PRIORITY_HIGH ? NOTIF_PRIORITY_HIGH : frame[3];
+
+            // Messages which are too long are cut to fit the slot
+            status = store(frame + NOTIF_HEADER_SIZE, length > NOTIF_MAX_TEXT_LEN ? NOTIF_MAX_TEXT_LEN : length,
+                           priority);
+            if (status != NOTIF_STATUS_DROPPED)
+            {
+                accepted++;
+            }
+            if (statusCounts[status] < 255)
+            {
+                statusCounts[status]++;
+            }
+
+            offset += NOTIF_HEADER_SIZE + length;
+        }
+
+        // Let the sender know what happened to the frames, it uses this to measure latency and losses
+        uint8_t ack[NOTIF_ACK_SIZE] = {'S', 'W', NOTIF_ACK_TYPE, sequence, status, statusCounts[NOTIF_STATUS_STORED],
+                                       statusCounts[NOTIF_STATUS_COALESCED], statusCounts[NOTIF_STATUS_DROPPED]};
+        sendto(socketFd, ack, sizeof(ack), MSG_DONTWAIT, (struct sockaddr *)&sender, senderLength);
+    }
+
+    return accepted;
+}
+
+/**
+ * @brief Get the number of stored notifications
+ *
+ */
+uint8_t Notifications::count()
+{
+    return numStored;
+}
+
+/**
+ * @brief Get the number of notifications which weren't shown yet
+ *
+ */
+uint8_t Notifications::unreadCount()
+{
+    return numUnread;
+}
+
+/**
+ * @brief Get a stored notification
+ *
+ * @param _index 0 is the newest notification
+ * @return const Notification* or nullptr if the index is out of range
+ */
+const Notification *Notifications::get(uint8_t _index)
+{
+    if (_index >= numStored)
+    {
+        return nullptr;
+    }
+    return &slots[order[numStored - 1 - _index]];
+}
+
+/**
+ * @brief Mark all notifications as shown
+ *
+ */
+void Notifications::markAllRead()
+{
+    numUnread = 0;
+}
+
+/**
+ * @brief Get the highest priority among the unread notifications, used to pick the LED flash
+ *
+ * @return uint8_t one of NOTIF_PRIORITY_*
+ */
+uint8_t Notifications::highestUnreadPriority()
+{
+    uint8_t highest = NOTIF_PRIORITY_LOW;
+    for (int i = numStored - numUnread; i < numStored; i++)
+    {
+        if (slots[order[i]].priority > highest)
+        {
+            highest = slots[order[i]].priority;
+        }
+    }
+    return highest;
+}
+
+/**
+ * @brief Get how many notifications were dropped or evicted because the buffer was full
+ *
+ */
+uint32_t Notifications::droppedCount()
+{
+    return numDropped;
+}
+
+/**
+ * @brief Store a notification, coalescing it with an identical one or making room for it if needed
+ *
+ * @note  When the buffer is full, the oldest notification of the lowest priority is evicted. If all stored
+ *        notifications have a higher priority than the new one, the new one is dropped instead
+ *
+ * @param _text pointer to the text inside the receive buffer, not null terminated
+ * @param _length length of the text, at most NOTIF_MAX_TEXT_LEN
+ * @param _priority one of NOTIF_PRIORITY_*
+ * @return uint8_t one of NOTIF_STATUS_*
+ */
+uint8_t Notifications::store(const uint8_t *_text, uint8_t _length, uint8_t _priority)
+{
+    // Replace characters the display can't show first, so the text is compared the same way it's stored
+    char text[NOTIF_MAX_TEXT_LEN + 1];
+    for (int i = 0; i < _length; i++)
+    {
+        text[i] = (_text[i] >= ' ' && _text[i] <= '~') ? _text[i] : '?';
+    }
+    text[_length] = '\0';
+
+    // If the same message is already here, just count it and move it to the front
+    for (int position = 0; position < numStored; position++)
+    {
+        Notification *existing = &slots[order[position]];
+        if (strcmp(existing->text, text) == 0)
+        {
+            if (existing->repeatCount < 255)
+            {
+                existing->repeatCount++;
+            }
+            if (_priority > existing->priority)
+            {
+                existing->priority = _priority;
+            }
+            existing->receivedAt = millis();
+
+            // A coalesced message which was already read becomes unread again
+            bool wasUnread = position >= numStored - numUnread;
+            uint8_t slotIndex = order[position];
+            memmove(&order[position], &order[position + 1], numStored - 1 - position);
+            order[numStored - 1] = slotIndex;
+            if (!wasUnread)
+            {
+                numUnread++;
+            }
+            return NOTIF_STATUS_COALESCED;
+        }
+    }
+
+    // Make room if the buffer is full
+    if (numStored == NOTIF_CAPACITY)
+    {
+        // Find the oldest notification with the lowest priority
+        uint8_t victim = 0;
+        for (int position = 1; position < numStored; position++)
+        {
+            if (slots[order[position]].priority < slots[order[victim]].priority)
+            {
+                victim = position;
+            }
+        }
+
+        numDropped++;
+        if (slots[order[victim]].priority > _priority)
+        {
+            // Everything stored is more important, drop the new one
+            return NOTIF_STATUS_DROPPED;
+        }
+        removeAt(victim);
+    }
+
+    // Find a free slot, there is always one at this point
+    uint8_t slotIndex = 0;
+    while (slots[slotIndex].text[0] != '\0')
+    {
+        slotIndex++;
+    }
+
+    Notification *notification = &slots[slotIndex];
+    memcpy(notification->text, text, _length + 1);
+    notification->priority = _priority;
+    notification->repeatCount = 1;
+    notification->receivedAt = millis();
+
+    // Append it as the newest one
+    order[numStored++] = slotIndex;
+    numUnread++;
+    return NOTIF_STATUS_STORED;
+}
+
+/**
+ * @brief Remove a notification from the buffer and free its slot
+ *
+ * @param _position position in the order array, 0 is the oldest
+ */
+void Notifications::removeAt(uint8_t _position)
+{
+    if (_position >= numStored - numUnread)
+    {
+        numUnread--;
+    }
+    slots[order[_position]].text[0] = '\0';
+    memmove(&order[_position], &order[_position + 1], numStored - 1 - _position);
+    numStored--;
+}
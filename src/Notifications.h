@@ -0,0 +1,62 @@
+#ifndef __SMART_WATCH_NOTIFICATIONS__
+#define __SMART_WATCH_NOTIFICATIONS__
+
+#include "defines.h"
+#include <Arduino.h>
+
+// Notification priorities, they also select the LED flash pattern
+#define NOTIF_PRIORITY_LOW    0
+#define NOTIF_PRIORITY_NORMAL 1
+#define NOTIF_PRIORITY_HIGH   2
+
+// What happened to a received notification, this is also sent back in the ack
+#define NOTIF_STATUS_STORED    0
+#define NOTIF_STATUS_COALESCED 1
+#define NOTIF_STATUS_DROPPED   2
+#define NOTIF_STATUS_MALFORMED 3
+
+// Frame layout, all frames are sent over UDP, a single datagram may carry several frames:
+// [0] 'S' [1] 'W' [2] NOTIF_PROTOCOL_VERSION [3] priority [4] sequence number [5] text length [6...] text (no null)
+// For every datagram, the watch answers with an ack:
+// [0] 'S' [1] 'W' [2] NOTIF_ACK_TYPE [3] sequence number of the last frame [4] status of the last frame
+// [5] frames stored [6] frames coalesced [7] frames dropped, counted over the whole datagram
+#define NOTIF_PROTOCOL_VERSION 1
+#define NOTIF_ACK_TYPE         0x81
+#define NOTIF_HEADER_SIZE      6
+#define NOTIF_ACK_SIZE         8
+
+// One stored notification, the text is kept in place, no heap is used
+struct Notification
+{
+    char text[NOTIF_MAX_TEXT_LEN + 1]; // Null terminated message text
+    uint8_t priority;                  // One of NOTIF_PRIORITY_*
+    uint8_t repeatCount;               // How many times the same message was received
+    uint32_t receivedAt;               // millis() of the last time it was received
+};
+
+class Notifications
+{
+  public:
+    Notifications();
+    bool begin(uint16_t _port);
+    uint8_t poll();
+    uint8_t count();
+    uint8_t unreadCount();
+    const Notification *get(uint8_t _index);
+    void markAllRead();
+    uint8_t highestUnreadPriority();
+    uint32_t droppedCount();
+
+  private:
+    int socketFd;
+    uint8_t rxBuffer[NOTIF_RX_BUFFER_SIZE];
+    Notification slots[NOTIF_CAPACITY];
+    uint8_t order[NOTIF_CAPACITY]; // Slot indexes, oldest first
+    uint8_t numStored;
+    uint8_t numUnread;
+    uint32_t numDropped;
+    uint8_t store(const uint8_t *_text, uint8_t _length, uint8_t _priority);
+    void removeAt(uint8_t _position);
+};
+
+#endif
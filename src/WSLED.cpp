@@ -1,16 +1,32 @@
 #include "WSLED.h"
+#include "Notifications.h"
+#include "defines.h"
+#include <new>
 
-Wsled::Wsled()
+Wsled::Wsled() : onBoardLed(nullptr)
 {
 }
 
 bool Wsled::begin()
 {
+    // Already initialized
+    if (onBoardLed != nullptr)
+    {
+        return false;
+    }
+
+#if STATIC_ALLOCATION
+    // Construct it in static storage instead of on the heap
+    alignas(WS2812) static uint8_t onBoardLedStorage[sizeof(WS2812)];
+    onBoardLed = new (onBoardLedStorage) WS2812(1, LEDWS_BUILTIN);
+#else
     onBoardLed = new WS2812(1, LEDWS_BUILTIN);
+#endif
     onBoardLed->begin();
     onBoardLed->setBrightness(254);
     onBoardLed->clear();
     onBoardLed->show();
+    return true;
 }
 
 void Wsled::ledOff()
@@ -33,6 +49,14 @@ void Wsled::showMenuColor(uint8_t _menuPage)
     {
         onBoardLed->setPixelColor(0, onBoardLed->Color(255, 0, 255));
     }
+    else if (_menuPage == 3)
+    {
+        onBoardLed->setPixelColor(0, onBoardLed->Color(255, 255, 0));
+    }
+    else if (_menuPage == 4)
+    {
+        onBoardLed->setPixelColor(0, onBoardLed->Color(0, 0, 255));
+    }
     else
     {
         onBoardLed->setPixelColor(0, onBoardLed->Color(255, 255, 255));
@@ -41,6 +65,31 @@ void Wsled::showMenuColor(uint8_t _menuPage)
 }
 
 void Wsled::redBlink()
+{
+    fadeBlink(255, 0, 0);
+}
+
+void Wsled::notificationBlink(uint8_t _priority)
+{
+    // More important notifications blink more times and in a more alarming color
+    if (_priority == NOTIF_PRIORITY_LOW)
+    {
+        fadeBlink(0, 0, 255);
+    }
+    else if (_priority == NOTIF_PRIORITY_NORMAL)
+    {
+        fadeBlink(0, 255, 0);
+        fadeBlink(0, 255, 0);
+    }
+    else
+    {
+        fadeBlink(255, 0, 0);
+        fadeBlink(255, 0, 0);
+        fadeBlink(255, 0, 0);
+    }
+}
+
+void Wsled::fadeBlink(uint8_t _red, uint8_t _green, uint8_t _blue)
 {
     unsigned long startTime = millis();
     unsigned long endTime = startTime + 200; // 200 ms from start
@@ -51,11 +100,9 @@ void Wsled::redBlink()
         // Calculate how far along we are in the fade process (0.0 to 1.0)
         float progress = float(currentTime - startTime) / (endTime - startTime);
 
-        // Calculate the current red value (255 at start, 0 at end)
-        int redValue = 255 * (1 - progress);
-
-        // Update the LED color
-        onBoardLed->setPixelColor(0, onBoardLed->Color(redValue, 0, 0));
+        // Update the LED color, full brightness at start, off at end
+        onBoardLed->setPixelColor(
+            0, onBoardLed->Color(_red * (1 - progress), _green * (1 - progress), _blue * (1 - progress)));
         onBoardLed->show();
 
         // Wait a bit before updating again
@@ -11,9 +11,11 @@ class Wsled
     void ledOff();
     void showMenuColor(uint8_t _menuPage);
     void redBlink();
+    void notificationBlink(uint8_t _priority);
 
   private:
     WS2812 * onBoardLed;
+    void fadeBlink(uint8_t _red, uint8_t _green, uint8_t _blue);
 };
 
 #endif
\ No newline at end of file
@@ -12,6 +12,12 @@
         Serial.flush();                                                                                                \
     }
 
+// Set this to false to let the drivers allocate their objects on the heap
+// When true, all driver objects are placed in static memory. Either way, every heap allocation the main loop makes
+// after setup() is printed as an error, if the core was built with CONFIG_HEAP_USE_HOOKS. make -C test checks the
+// same on a computer
+#define STATIC_ALLOCATION true
+
 // WiFi credentials
 // The smart watch will attempt to connect to this WiFi to re-sync the time
 const static char *ssid = "Soldered";
@@ -35,16 +41,62 @@ const static char *timeZone = "CET-1CEST,M3.5.0,M10.5.0/3";
 // You can use this to fine-tune the time saved to the RTC
 #define RTC_SECONDS_OFFSET 10
 
-// Timeout for the menu, before returning to the main loop
+// Timeout for the menu, before launching the selected page
+// Double tap the watch to launch it right away
 #define MENU_TIMEOUT_MS 1500
 
+// Number of menu pages, including the exit page
+#define MENU_NUM_PAGES 6
+
+// Watch face settings
+#define STEP_GOAL      10000 // Daily step goal, shown as a bar on faces which have one
+#define FACE_MAX_ITEMS 16    // Most shapes and widgets a face can have, up to 32
+
+// Activity estimates, set them to your own values
+#define USER_STRIDE_CM           75 // Length of one step
+#define USER_WEIGHT_KG           70 // Body weight, for the calorie estimate
+#define USER_KCAL_PER_KG_KM_X100 72 // Walking burns about 0.72 kcal per kg of body weight per km
+#define ACTIVE_MINUTE_STEPS      60 // A minute with at least this many steps counts as active
+
+// Notification receiver settings
+// Use tools/notify.py to send notifications to the watch
+#define NOTIF_UDP_PORT             4210
+#define NOTIF_CAPACITY             8     // How many notifications are kept, the oldest least important are evicted
+#define NOTIF_MAX_TEXT_LEN         63    // Longer messages are cut
+#define NOTIF_RX_BUFFER_SIZE       512   // Size of the datagram receive buffer, at least one 255 character frame
+#define NOTIF_MAX_PACKETS_PER_POLL 4     // Limits the time spent receiving during a flood
+#define NOTIF_TICKER_TIMEOUT_MS    10000 // Return to the watch face if there was no button press for this long
+
 // Display settings
 #define OLED_WIDTH  128
 #define OLED_HEIGHT 64
 
+// I2C addresses of the display and the gyroscope
+#define OLED_I2C_ADDRESS 0x3C
+#define GYRO_I2C_ADDRESS 0x6B
+
+// I2C bus settings
+// Both the SSD1306 and the LSM6DS3 are rated for Fast-mode (400 kHz). The ESP32 can also run Fast-mode Plus
+// (1000000), only use it if your display module and wiring handle it, otherwise the display will glitch
+#define I2C_BUS_CLOCK_HZ        400000
+#define I2C_DISPLAY_CHUNK_BYTES 64   // The frame is sent in chunks of this size, sensor reads can go in between
+#define I2C_QUEUE_LENGTH        8    // How many sensor reads can be queued
+#define I2C_MAX_READ_BYTES      8    // Longest sensor read
+#define I2C_SERVICE_BUDGET_US   2000 // How long the main loop spends on the bus between button checks
+
+// How often to print bus and memory statistics on the debug Serial
+#define STATS_REPORT_INTERVAL_MS 60000
+
 // Button pin
 #define BUTTON_PIN 4
 
+// The pin the gyroscope INT1 pin is wired to, it signals taps
+#define GYRO_INT_PIN 27
+
+// Tap input settings
+#define TAP_DOUBLE_WINDOW_MS 250 // A single tap is only reported if no second tap follows within this time
+#define INPUT_QUEUE_LENGTH   8   // How many input events can wait to be handled
+
 // Battery voltage read pin
 #define BATTERY_VOLTAGE_PIN 33
 
@@ -62,6 +114,8 @@ const static char *timeZone = "CET-1CEST,M3.5.0,M10.5.0/3";
 #define MENU_PAGE_0_TEXT "     WiFi Scanner"
 #define MENU_PAGE_1_TEXT " Gyroscope Animation"
 #define MENU_PAGE_2_TEXT "    Self Destruct"
-#define MENU_PAGE_3_TEXT "      Exit Menu"
+#define MENU_PAGE_3_TEXT "    Notifications"
+#define MENU_PAGE_4_TEXT "     Change Face"
+#define MENU_PAGE_5_TEXT "      Exit Menu"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+// Just enough of the Arduino core to build the hardware independent parts of the sketch on a computer
+#ifndef __SMART_WATCH_TEST_ARDUINO__
+#define __SMART_WATCH_TEST_ARDUINO__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+// The tests move the clock themselves
+extern uint32_t testMillis;
+inline uint32_t millis()
+{
+    return testMillis;
+}
+inline uint32_t micros()
+{
+    return testMillis * 1000;
+}
+
+template <class T> inline T min(T _a, T _b)
+{
+    return _a < _b ? _a : _b;
+}
+
+#endif
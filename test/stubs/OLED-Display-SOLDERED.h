@@ -0,0 +1,49 @@
+// Stands in for the OLED display library, drawing does nothing, printed text is counted
+#ifndef __SMART_WATCH_TEST_OLED_DISPLAY__
+#define __SMART_WATCH_TEST_OLED_DISPLAY__
+
+#include <Arduino.h>
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+
+class OLED_Display
+{
+  public:
+    uint32_t numPrints = 0;
+
+    void clearDisplay()
+    {
+    }
+    void setTextWrap(bool _wrap)
+    {
+    }
+    void setTextColor(uint16_t _color, uint16_t _background)
+    {
+    }
+    void setTextSize(uint8_t _size)
+    {
+    }
+    void setCursor(int16_t _x, int16_t _y)
+    {
+    }
+    void print(const char *_text)
+    {
+        numPrints++;
+    }
+    void drawLine(int16_t _x0, int16_t _y0, int16_t _x1, int16_t _y1, uint16_t _color)
+    {
+    }
+    void drawRect(int16_t _x, int16_t _y, int16_t _width, int16_t _height, uint16_t _color)
+    {
+    }
+    void fillRect(int16_t _x, int16_t _y, int16_t _width, int16_t _height, uint16_t _color)
+    {
+    }
+    void drawBitmap(int16_t _x, int16_t _y, const uint8_t *_bitmap, int16_t _width, int16_t _height, uint16_t _color,
+                    uint16_t _background)
+    {
+    }
+};
+
+#endif
@@ -0,0 +1,11 @@
+// lwIP uses the BSD socket API, so on a computer the system sockets take its place
+#ifndef __SMART_WATCH_TEST_LWIP_SOCKETS__
+#define __SMART_WATCH_TEST_LWIP_SOCKETS__
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#endif
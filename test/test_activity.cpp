@@ -0,0 +1,198 @@
+// Replays synthetic step streams through Activity, the same way the main loop feeds it
+// Run with: make -C test
+
+#include "Activity.h"
+#include <stdio.h>
+
+static int numFailures = 0;
+
+#define CHECK(condition)                                                                                               \
+    if (!(condition))                                                                                                  \
+    {                                                                                                                  \
+        printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);                                                  \
+        numFailures++;                                                                                                 \
+    }
+
+#define CHECK_NEAR(value, expected, tolerance)                                                                         \
+    if ((long)(value) < (long)(expected) - (tolerance) || (long)(value) > (long)(expected) + (tolerance))              \
+    {                                                                                                                  \
+        printf("%s:%d: %s is %ld, expected %ld\n", __FILE__, __LINE__, #value, (long)(value), (long)(expected));       \
+        numFailures++;                                                                                                 \
+    }
+
+// Stands in for the gyroscope step counter and the RTC
+struct Walker
+{
+    Activity activity;
+    time_t now;
+    uint32_t totalSteps;
+    uint32_t fraction; // Steps times 60, so any cadence adds up exactly
+
+    Walker(time_t _start) : now(_start), totalSteps(0), fraction(0)
+    {
+        activity.update(now, totalSteps);
+    }
+
+    // Walk at a steady cadence, updating every _interval seconds like the main loop does
+    void walk(uint32_t _stepsPerMinute, time_t _seconds, time_t _interval = 2)
+    {
+        for (time_t t = 0; t < _seconds; t += _interval)
+        {
+            now += _interval;
+            fraction += _stepsPerMinute * _interval;
+            totalSteps += fraction / 60;
+            fraction %= 60;
+            activity.update(now, totalSteps);
+        }
+    }
+
+    // Nothing was updated for a while, the steps show up all at once in the next update
+    void gap(time_t _seconds, uint32_t _steps)
+    {
+        now += _seconds;
+        totalSteps += _steps;
+        activity.update(now, totalSteps);
+    }
+};
+
+// Start on a minute boundary, so minutes are easy to count
+#define START_TIME 1700000040
+
+static void testSteadyCadence()
+{
+    Walker walker(START_TIME);
+    walker.walk(100, 12 * 60);
+    CHECK_NEAR(walker.activity.cadence(), 100, 2);
+    CHECK_NEAR(walker.activity.cadenceLong(), 100, 2);
+    CHECK_NEAR(walker.activity.dailySteps(), 1200, 2);
+}
+
+static void testLongWindow()
+{
+    Walker walker(START_TIME);
+
+    // Only the last 10 complete minutes count, the first 10 fall out of the window
+    walker.walk(60, 10 * 60);
+    walker.walk(120, 5 * 60);
+    walker.walk(0, 5 * 60);
+    CHECK_NEAR(walker.activity.cadenceLong(), 60, 2);
+    CHECK(walker.activity.cadence() == 0);
+
+    walker.walk(0, 10 * 60);
+    CHECK(walker.activity.cadenceLong() == 0);
+}
+
+static void testActiveMinutesAndStreaks()
+{
+    Walker walker(START_TIME);
+    walker.walk(100, 3 * 60);
+    walker.walk(10, 2 * 60);
+    walker.walk(100, 5 * 60);
+    walker.walk(0, 60);
+
+    CHECK(walker.activity.activeMinutes() == 8);
+    CHECK(walker.activity.longestStreak() == 5);
+    CHECK(walker.activity.currentStreak() == 0);
+
+    walker.walk(100, 2 * 60);
+    CHECK(walker.activity.currentStreak() == 2);
+    CHECK(walker.activity.longestStreak() == 5);
+
+    // A new day starts the counts over
+    walker.activity.resetDay();
+    walker.totalSteps = 0;
+    walker.activity.update(walker.now, 0);
+    CHECK(walker.activity.dailySteps() == 0);
+    CHECK(walker.activity.activeMinutes() == 0);
+    CHECK(walker.activity.longestStreak() == 0);
+}
+
+static void testCounterReset()
+{
+    Walker walker(START_TIME);
+    walker.walk(100, 60);
+    uint32_t before = walker.activity.dailySteps();
+
+    // The gyroscope was reconfigured, its count starts from 0 again
+    walker.totalSteps = 20;
+    walker.now += 2;
+    walker.activity.update(walker.now, walker.totalSteps);
+    CHECK(walker.activity.dailySteps() == before + 20);
+
+    walker.walk(100, 60);
+    CHECK_NEAR(walker.activity.dailySteps(), before + 20 + 100, 2);
+}
+
+static void testClockBackwards()
+{
+    Walker walker(START_TIME);
+    walker.walk(100, 5 * 60);
+    uint32_t before = walker.activity.dailySteps();
+
+    // An RTC sync moved the clock back, the windows start over but no steps are lost
+    walker.now -= 3600;
+    walker.totalSteps += 10;
+    walker.activity.update(walker.now, walker.totalSteps);
+    CHECK(walker.activity.dailySteps() == before + 10);
+    CHECK(walker.activity.cadence() == 10);
+
+    walker.walk(100, 2 * 60);
+    CHECK_NEAR(walker.activity.cadence(), 100, 2);
+    CHECK_NEAR(walker.activity.dailySteps(), before + 10 + 200, 2);
+}
+
+static void testGap()
+{
+    Walker walker(START_TIME);
+    walker.walk(100, 5 * 60);
+    CHECK(walker.activity.currentStreak() == 5);
+
+    // A blocking screen kept the loop away for 5 minutes of walking at the same cadence
+    walker.gap(300, 500);
+    CHECK_NEAR(walker.activity.cadence(), 100, 2);
+    CHECK(walker.activity.currentStreak() == 10);
+    CHECK(walker.activity.activeMinutes() == 10);
+    CHECK_NEAR(walker.activity.dailySteps(), 1000, 2);
+
+    // A gap longer than the long window, the minutes before it still count as active
+    walker.gap(3600, 6000);
+    CHECK_NEAR(walker.activity.cadence(), 100, 2);
+    CHECK_NEAR(walker.activity.cadenceLong(), 100, 2);
+    CHECK(walker.activity.activeMinutes() == 70);
+    CHECK(walker.activity.longestStreak() == 70);
+
+    // A gap without steps breaks the streak
+    walker.gap(600, 0);
+    CHECK(walker.activity.cadence() == 0);
+    CHECK(walker.activity.currentStreak() == 0);
+    CHECK(walker.activity.longestStreak() == 70);
+}
+
+static void testEstimates()
+{
+    Walker walker(START_TIME);
+    walker.walk(100, 10 * 60);
+    CHECK(walker.activity.dailySteps() == 1000);
+    CHECK(walker.activity.distanceMeters() == 1000 * USER_STRIDE_CM / 100);
+    CHECK(walker.activity.calories() ==
+          (uint32_t)(1000ULL * USER_STRIDE_CM * USER_WEIGHT_KG * USER_KCAL_PER_KG_KM_X100 / 10000000ULL));
+}
+
+int main()
+{
+    testSteadyCadence();
+    testLongWindow();
+    testActiveMinutesAndStreaks();
+    testCounterReset();
+    testClockBackwards();
+    testGap();
+    testEstimates();
+
+    if (numFailures > 0)
+    {
+        printf("%d checks failed\n", numFailures);
+        return 1;
+    }
+    printf("All activity tests passed\n");
+    return 0;
+}
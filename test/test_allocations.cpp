@@ -0,0 +1,226 @@
+// Checks that the code the main loop runs never allocates on the heap once setup() is done
+// Every malloc, calloc, realloc and new is counted, which needs glibc (Linux)
+// Run with: make -C test
+
+#include "Activity.h"
+#include "FaceRenderer.h"
+#include "Faces.h"
+#include "Notifications.h"
+#include "lwip/sockets.h"
+
+// A free port on this computer, the notification receiver listens on it
+#define TEST_UDP_PORT 42107
+
+// Loop passes to run, about 25 minutes of watch time
+#define TEST_PASSES 1000
+
+uint32_t testMillis = 0;
+
+// Allocation counting, all allocation functions go through these
+extern "C" void *__libc_malloc(size_t _size);
+extern "C" void *__libc_calloc(size_t _count, size_t _size);
+extern "C" void *__libc_realloc(void *_pointer, size_t _size);
+extern "C" void __libc_free(void *_pointer);
+
+static bool counting = false;
+static uint32_t numAllocations = 0;
+static size_t allocatedBytes = 0;
+static int currentPass = -1;
+static int firstAllocationPass = -1;
+
+static void countAllocation(size_t _size)
+{
+    if (counting)
+    {
+        numAllocations++;
+        allocatedBytes += _size;
+        if (firstAllocationPass < 0)
+        {
+            firstAllocationPass = currentPass;
+        }
+    }
+}
+
+extern "C" void *malloc(size_t _size)
+{
+    countAllocation(_size);
+    return __libc_malloc(_size);
+}
+
+extern "C" void *calloc(size_t _count, size_t _size)
+{
+    countAllocation(_count * _size);
+    return __libc_calloc(_count, _size);
+}
+
+extern "C" void *realloc(void *_pointer, size_t _size)
+{
+    countAllocation(_size);
+    return __libc_realloc(_pointer, _size);
+}
+
+extern "C" void free(void *_pointer)
+{
+    __libc_free(_pointer);
+}
+
+// Everything is created the same way the sketch does it, as globals
+static Activity activity;
+static FaceRenderer renderer;
+static OLED_Display display;
+static Notifications notifications;
+
+// Sends notifications to the receiver, like tools/notify.py
+static int senderFd = -1;
+static struct sockaddr_in receiverAddress;
+
+static void sendNotifications(const char *const *_texts, int _count, uint8_t _priority, uint8_t _sequence)
+{
+    uint8_t datagram[NOTIF_RX_BUFFER_SIZE];
+    int length = 0;
+    for (int i = 0; i < _count; i++)
+    {
+        uint8_t textLength = strlen(_texts[i]);
+        const uint8_t header[NOTIF_HEADER_SIZE] = {'S', 'W', NOTIF_PROTOCOL_VERSION, _priority, _sequence, textLength};
+        memcpy(datagram + length, header, sizeof(header));
+        memcpy(datagram + length + NOTIF_HEADER_SIZE, _texts[i], textLength);
+        length += NOTIF_HEADER_SIZE + textLength;
+    }
+    sendto(senderFd, datagram, length, 0, (struct sockaddr *)&receiverAddress, sizeof(receiverAddress));
+
+    // Throw the acks away, so they don't pile up
+    uint8_t ack[NOTIF_ACK_SIZE];
+    while (recv(senderFd, ack, sizeof(ack), MSG_DONTWAIT) > 0)
+    {
+    }
+}
+
+// Messages the loop receives, with repeats, non ASCII text, batches and text which is too long
+static const char *const repeatedText[] = {"Build passed"};
+static const char *const utf8Text[] = {"Caf\xc3\xa9 at 5?\nSee you"};
+static const char *const batchTexts[] = {"First of a batch", "Second of a batch", "Third of a batch"};
+static const char *const longText[] = {
+    "This message is much longer than NOTIF_MAX_TEXT_LEN, so the watch has to cut it to fit the slot it is kept in, "
+    "without allocating a bigger one"};
+
+int main()
+{
+    // setup(): this is where allocating is fine
+    setenv("TZ", timeZone, 1);
+    tzset();
+    if (!notifications.begin(TEST_UDP_PORT))
+    {
+        printf("Couldn't start the notification receiver on port %d\n", TEST_UDP_PORT);
+        return 1;
+    }
+    senderFd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    memset(&receiverAddress, 0, sizeof(receiverAddress));
+    receiverAddress.sin_family = AF_INET;
+    receiverAddress.sin_port = htons(TEST_UDP_PORT);
+    receiverAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    renderer.setFace(faces[0]);
+
+    // loop(): nothing may allocate from here on
+    time_t now = 1700000000;
+    uint32_t steps = 0;
+    char uniqueText[32];
+    const char *uniqueTexts[] = {uniqueText};
+    counting = true;
+    for (currentPass = 0; currentPass < TEST_PASSES; currentPass++)
+    {
+        now += 1;
+        testMillis += 1500;
+        steps += currentPass % 3;
+
+        activity.update(now, steps);
+
+        // Change the face every once in a while, like the menu does
+        if (currentPass % 100 == 99)
+        {
+            renderer.setFace(faces[currentPass / 100 % FACE_COUNT]);
+        }
+        FaceState state;
+        state.time = now;
+        state.steps = steps;
+        state.lowBattery = currentPass % 50 < 25;
+        state.syncFailed = currentPass % 70 < 10;
+        state.cadence = activity.cadence();
+        state.cadenceLong = activity.cadenceLong();
+        state.distanceMeters = activity.distanceMeters();
+        state.calories = activity.calories();
+        state.activeMinutes = activity.activeMinutes();
+        state.longestStreak = activity.longestStreak();
+        renderer.render(&display, &state);
+
+        switch (currentPass % 5)
+        {
+        case 0:
+            sendNotifications(repeatedText, 1, NOTIF_PRIORITY_NORMAL, currentPass);
+            break;
+        case 1:
+            sendNotifications(utf8Text, 1, NOTIF_PRIORITY_HIGH, currentPass);
+            break;
+        case 2:
+            sendNotifications(batchTexts, 3, NOTIF_PRIORITY_LOW, currentPass);
+            break;
+        case 3:
+            sendNotifications(longText, 1, NOTIF_PRIORITY_LOW, currentPass);
+            break;
+        default:
+            snprintf(uniqueText, sizeof(uniqueText), "Message %d", currentPass);
+            sendNotifications(uniqueTexts, 1, NOTIF_PRIORITY_NORMAL, currentPass);
+            break;
+        }
+        notifications.poll();
+        notifications.highestUnreadPriority();
+        if (currentPass % 10 == 0)
+        {
+            notifications.markAllRead();
+        }
+    }
+    counting = false;
+
+    int numFailures = 0;
+    if (numAllocations > 0)
+    {
+        printf("The loop allocated %u times (%u bytes), the first time in pass %d\n", (unsigned)numAllocations,
+               (unsigned)allocatedBytes, firstAllocationPass);
+        numFailures++;
+    }
+
+    // Make sure the code really ran
+    if (display.numPrints == 0)
+    {
+        printf("No watch face was drawn\n");
+        numFailures++;
+    }
+    if (notifications.count() != NOTIF_CAPACITY)
+    {
+        printf("%u notifications stored, expected %u\n", notifications.count(), NOTIF_CAPACITY);
+        numFailures++;
+    }
+
+    // Messages with characters the display can't show are coalesced too
+    bool utf8Coalesced = false;
+    for (int i = 0; i < notifications.count(); i++)
+    {
+        const Notification *notification = notifications.get(i);
+        if (strncmp(notification->text, "Caf?? at 5??See you", NOTIF_MAX_TEXT_LEN) == 0)
+        {
+            utf8Coalesced = notification->repeatCount > 1;
+        }
+    }
+    if (!utf8Coalesced)
+    {
+        printf("The non ASCII message wasn't coalesced\n");
+        numFailures++;
+    }
+
+    if (numFailures > 0)
+    {
+        printf("%d checks failed\n", numFailures);
+        return 1;
+    }
+    printf("No allocations in %d loop passes\n", TEST_PASSES);
+    return 0;
+}
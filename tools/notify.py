@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+Send notifications to the Soldered Smart Watch over UDP.
+
+Examples:
+    python3 tools/notify.py 192.168.1.50 "Meeting in 5 minutes"
+    python3 tools/notify.py 192.168.1.50 "Server down!" --priority high
+    python3 tools/notify.py 192.168.1.50 "Ping" --count 100 --interval 0 --unique
+    python3 tools/notify.py 192.168.1.50 "Flood" --count 1000 --pipeline --batch 4 --unique
+
+With --count, the tool also works as a benchmark. By default it waits for the ack of each
+datagram before sending the next one, which measures the ack round trip latency.
+With --pipeline it floods the watch without waiting, then collects the acks and reports how
+many frames were stored, coalesced or dropped by the watch and how many were lost on the way.
+"""
+
+import argparse
+import collections
+import socket
+import struct
+import time
+
+PROTOCOL_VERSION = 1
+ACK_TYPE = 0x81
+ACK_SIZE = 8
+PRIORITIES = {"low": 0, "normal": 1, "high": 2}
+STATUS_NAMES = ["stored", "coalesced", "dropped"]
+MAX_TEXT_LEN = 255
+RX_BUFFER_SIZE = 512  # NOTIF_RX_BUFFER_SIZE in defines.h, a datagram must fit in it
+
+
+def build_frame(text, priority, sequence):
+    payload = text.encode("ascii", errors="replace")[:MAX_TEXT_LEN]
+    return struct.pack("<2sBBBB", b"SW", PROTOCOL_VERSION, priority, sequence & 0xFF, len(payload)) + payload
+
+
+def build_datagrams(args):
+    """Number the messages and pack up to --batch frames into each datagram"""
+    datagrams = []
+    frames = []
+    size = 0
+    for i in range(args.count):
+        text = "%s %d" % (args.text, i) if args.unique else args.text
+        frame = build_frame(text, PRIORITIES[args.priority], i)
+        if frames and (len(frames) == args.batch or size + len(frame) > RX_BUFFER_SIZE):
+            datagrams.append((b"".join(frames), len(frames), (i - 1) & 0xFF))
+            frames = []
+            size = 0
+        frames.append(frame)
+        size += len(frame)
+    datagrams.append((b"".join(frames), len(frames), (args.count - 1) & 0xFF))
+    return datagrams
+
+
+class Results:
+    def __init__(self):
+        self.frames = {name: 0 for name in STATUS_NAMES}
+        self.malformed = 0
+        self.lost = 0
+        self.latencies = []
+        # Send times of the datagrams waiting for an ack, by the sequence number of their last frame
+        # The sequence number is only 8 bits, so the same one can wait several times, the older ones were lost
+        self.waiting = collections.defaultdict(collections.deque)
+
+    def sent(self, sequence, num_frames):
+        self.waiting[sequence].append((time.perf_counter(), num_frames))
+
+    def receive(self, sock):
+        """Handle one ack, returns the sequence number it was for, raises socket.timeout if none came"""
+        data, _ = sock.recvfrom(16)
+        if len(data) != ACK_SIZE or data[:2] != b"SW" or data[2] != ACK_TYPE or not self.waiting[data[3]]:
+            return None
+        sent_at, num_frames = self.waiting[data[3]].pop()
+        self.latencies.append(time.perf_counter() - sent_at)
+        counts = data[5:8]
+        for name, count in zip(STATUS_NAMES, counts):
+            self.frames[name] += count
+        self.malformed += num_frames - sum(counts)
+        return data[3]
+
+    def collect(self, sock):
+        """Read the acks which already arrived without waiting"""
+        sock.setblocking(False)
+        try:
+            while True:
+                self.receive(sock)
+        except (BlockingIOError, socket.timeout):
+            pass
+
+    def finish(self, sock, timeout):
+        """Wait for the remaining acks, everything still unanswered after the timeout was lost"""
+        sock.settimeout(timeout)
+        try:
+            while any(self.waiting.values()):
+                self.receive(sock)
+        except socket.timeout:
+            pass
+        self.lost += sum(num_frames for queue in self.waiting.values() for _, num_frames in queue)
+        self.waiting.clear()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Send notifications to the Soldered Smart Watch")
+    parser.add_argument("host", help="IP address of the watch")
+    parser.add_argument("text", help="Notification text, 63 characters are shown")
+    parser.add_argument("--port", type=int, default=4210, help="UDP port, NOTIF_UDP_PORT in defines.h")
+    parser.add_argument("--priority", choices=PRIORITIES.keys(), default="normal")
+    parser.add_argument("--count", type=int, default=1, help="How many notifications to send")
+    parser.add_argument("--interval", type=float, help="Seconds between datagrams, 0.05 or 0 with --pipeline")
+    parser.add_argument("--unique", action="store_true", help="Number the messages so they aren't coalesced")
+    parser.add_argument("--timeout", type=float, default=0.5, help="Seconds to wait for an ack")
+    parser.add_argument("--pipeline", action="store_true", help="Send without waiting for acks, to flood the watch")
+    parser.add_argument("--batch", type=int, default=1, help="Frames per datagram")
+    args = parser.parse_args()
+    args.batch = max(1, args.batch)
+    if args.interval is None:
+        args.interval = 0 if args.pipeline else 0.05
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    datagrams = build_datagrams(args)
+    results = Results()
+
+    start = time.perf_counter()
+    for payload, num_frames, sequence in datagrams:
+        results.sent(sequence, num_frames)
+        sock.sendto(payload, (args.host, args.port))
+
+        if args.pipeline:
+            # Don't wait, only take the acks which are already here so the socket buffer doesn't overflow
+            results.collect(sock)
+        else:
+            # Wait for the ack of this datagram, the watch answers every datagram
+            sock.settimeout(args.timeout)
+            try:
+                while results.receive(sock) != sequence:
+                    pass
+            except socket.timeout:
+                pass
+
+        if args.interval > 0:
+            time.sleep(args.interval)
+    send_time = time.perf_counter() - start
+    results.finish(sock, args.timeout)
+
+    if args.count == 1:
+        answered = [name for name in STATUS_NAMES if results.frames[name]]
+        print("Ack: %s" % (answered[0] if answered else "malformed" if results.malformed else "none"))
+        return
+
+    print("Sent %d notifications in %d datagrams in %.2f s (%.1f msg/s)" % (
+        args.count, len(datagrams), send_time, args.count / send_time))
+    print("Watch reported: " + ", ".join("%s %d" % (k, v) for k, v in results.frames.items()) +
+          ", malformed %d, lost %d" % (results.malformed, results.lost))
+    if results.latencies:
+        latencies = sorted(results.latencies)
+        print("Ack latency: min %.1f ms, median %.1f ms, p99 %.1f ms, max %.1f ms" % (
+            latencies[0] * 1000,
+            latencies[len(latencies) // 2] * 1000,
+            latencies[min(len(latencies) - 1, int(len(latencies) * 0.99))] * 1000,
+            latencies[-1] * 1000))
+
+
+if __name__ == "__main__":
+    main()